@@ -9,19 +9,67 @@ COMPILE-TIME OPTIONS
     This global flag defines by which factor the dyn_array should grow if it exceeds the previous
     allocated size.
 
-    Default: ((c) * 1.5 - (c))
+    Default: DYN_ARRAY_GROW_FACTOR_1_5X(c) which is ((c) >> 1)
 
     The default adds 1.5 times the amount to the existing capacity.
     Because the value of "DYN_ARRAY_GROW_FACTOR_FUNCTION" is added to the current capacity
-    the macro substracts the capacity at the end "- (c)".
+    the macro only returns the additional capacity.
 
     Example of how this MACRO is used in the dyn_array implementation:
     capacity += add_length + (DYN_ARRAY_GROW_FACTOR_FUNCTION(capacity));
 
+    The following integer only policies are available:
+
+    DYN_ARRAY_GROW_FACTOR_1_5X(c)    1.5x    ((c) >> 1)
+    DYN_ARRAY_GROW_FACTOR_2X(c)      2x      (c)
+    DYN_ARRAY_GROW_FACTOR_GOLDEN(c)  ~1.618x ((c) >> 1) + ((c) >> 3) - ((c) >> 7)
+
+    Example golden ratio growth:
+    #define DYN_ARRAY_GROW_FACTOR_FUNCTION(c) DYN_ARRAY_GROW_FACTOR_GOLDEN(c)
+    #include "dyn_array.h"
+
     Example fixed growth add memory for 16 more elements:
     #define DYN_ARRAY_GROW_FACTOR_FUNCTION(c) (16)
     #include "dyn_array.h"
 
+  #define DYN_ARRAY_GROW_MIN_BYTES
+
+    Minimum amount of element bytes allocated whenever an array grows (Default: not set).
+    Avoids the tiny 1, 2, 3, 4, 6 ... element reallocations of arrays starting empty.
+
+    Example first growth allocates at least 64 bytes worth of elements:
+    #define DYN_ARRAY_GROW_MIN_BYTES 64
+    #include "dyn_array.h"
+
+  #define DYN_ARRAY_GROW_ROUND_FUNCTION(b)
+
+    Rounds the total allocation size in bytes (header included) of a growth up. The capacity is
+    then set to the number of elements which fit into the rounded size so the slack that the
+    allocator hands out anyway is actually used (Default: not set).
+
+    The following rounding functions are available:
+
+    DYN_ARRAY_GROW_ROUND_MALLOC(b)      malloc (ptmalloc) chunk sizes: 16 byte steps minus 8 bytes of chunk header
+    DYN_ARRAY_GROW_ROUND_PAGE(b)        multiple of DYN_ARRAY_PAGE_SIZE (Default: 4096)
+    DYN_ARRAY_GROW_ROUND_SIZE_CLASS(b)  malloc chunk size below DYN_ARRAY_PAGE_SIZE, page multiple above
+
+    Example:
+    #define DYN_ARRAY_GROW_ROUND_FUNCTION(b) DYN_ARRAY_GROW_ROUND_SIZE_CLASS(b)
+    #include "dyn_array.h"
+
+  #define DYN_ARRAY_AUTO_SHRINK
+
+    Shrinks the capacity of an array once "dyn_array_del" or "dyn_array_resize" drops its length below
+    1 / DYN_ARRAY_SHRINK_DIVISOR (Default: 4) of the capacity. The new capacity is twice the length so
+    an array oscillating around a size does not realloc on every add/del (hysteresis).
+    Arrays with a capacity of at most DYN_ARRAY_SHRINK_MIN_BYTES (Default: 4096) bytes never shrink
+    automatically. "dyn_array_clear" always keeps the storage. A failed shrink keeps the array as is.
+
+    Example:
+    #define DYN_ARRAY_AUTO_SHRINK
+    #define DYN_ARRAY_SHRINK_MIN_BYTES 65536
+    #include "dyn_array.h"
+
   #define DYN_ARRAY_FUNCTION_REALLOC
   #define DYN_ARRAY_FUNCTION_FREE
 
@@ -33,6 +81,173 @@ COMPILE-TIME OPTIONS
     #define DYN_ARRAY_FUNCTION_FREE(p)       (a_better_free_implementation(p))
     #include "dyn_array.h"
 
+  #define DYN_ARRAY_SIZE_T
+
+    Stores the length and capacity of the arrays (and the statistic counts) as pointer sized
+    integers instead of "unsigned int" to support arrays beyond 4 billion elements or 4GB.
+    The header grows from 16 to 32 bytes on 64-bit, padded to a multiple of two pointers so element 0
+    keeps the 16 byte alignment of malloc (e.g. for "long double" or SSE types). In both modes the byte size of an allocation
+    is computed overflow checked and a growth that would overflow fails like a failed realloc.
+
+  #define DYN_ARRAY_HEADER_COMPACT
+
+    Removes the "data" pointer from the header stored in front of every array. The header shrinks
+    from 16 to 8 bytes on 64-bit which adds up for millions of small arrays. Arrays on caller
+    provided storage ("dyn_array_init_buffer") are not available in this mode.
+
+  #define DYN_ARRAY_ALIGNMENT
+
+    Aligns element 0 of every array to the given power of two (e.g. 32 for AVX2, 64 for a cache line
+    or AVX-512) independent of the alignment the allocator returns. The header is padded to a multiple
+    of the alignment and up to DYN_ARRAY_ALIGNMENT - 1 additional bytes are allocated per array.
+
+    Example:
+    #define DYN_ARRAY_ALIGNMENT 64
+    #include "dyn_array.h"
+
+  #define DYN_ARRAY_VIRTUAL_MEMORY
+
+    Provides "dyn_array_vm_realloc" and "dyn_array_vm_free" which can be plugged into the realloc/free
+    hooks. Every array reserves a large virtual address range up front (mmap PROT_NONE / VirtualAlloc
+    MEM_RESERVE) and commits pages on demand as the capacity grows. The data pointer never moves and a
+    growth costs O(new pages) instead of copying the whole array.
+
+    Intended for a few very large arrays since each array occupies "DYN_ARRAY_VM_RESERVE_SIZE" bytes of
+    address space (Default: 64GB on 64-bit, 256MB on 32-bit). Pages are committed in steps of
+    "DYN_ARRAY_VM_COMMIT_SIZE" bytes (Default: 64KB). If the reservation is exhausted the array moves
+    once into a reservation twice as large.
+
+    Example:
+    #define DYN_ARRAY_VIRTUAL_MEMORY
+    #define DYN_ARRAY_FUNCTION_REALLOC(p, s) (dyn_array_vm_realloc(p, s))
+    #define DYN_ARRAY_FUNCTION_FREE(p)       (dyn_array_vm_free(p))
+    #include "dyn_array.h"
+
+  #define DYN_ARRAY_MREMAP
+
+    Linux only. Provides "dyn_array_mremap_realloc" and "dyn_array_mremap_free" which can be plugged into
+    the realloc/free hooks. Blocks below "DYN_ARRAY_MREMAP_THRESHOLD" bytes (Default: 256KB) are served from
+    the heap ("DYN_ARRAY_MREMAP_HEAP_REALLOC/FREE", Default: realloc/free). Larger blocks are page aligned
+    mappings which grow with mremap(MREMAP_MAYMOVE), so the kernel moves page table entries instead of
+    copying the array.
+
+    Example:
+    #define DYN_ARRAY_MREMAP
+    #define DYN_ARRAY_FUNCTION_REALLOC(p, s) (dyn_array_mremap_realloc(p, s))
+    #define DYN_ARRAY_FUNCTION_FREE(p)       (dyn_array_mremap_free(p))
+    #include "dyn_array.h"
+
+  #define DYN_ARRAY_PARALLEL
+
+    Provides a persistent worker pool and chunked "dyn_array_parallel_for", "dyn_array_parallel_reduce"
+    and "dyn_array_parallel_transform". The calling thread works as worker 0 and the others sleep between
+    jobs. Chunks are claimed from a shared atomic counter so threads which finish early take more chunks
+    (dynamic chunking for uneven per element costs). The chunk size is "pool->grain" (Default: 0 which
+    picks length / (threads * 16) but at least 4096 elements). Shorter arrays run on the calling thread.
+
+    Uses pthreads (POSIX) or Win32 threads by default. Like the realloc/free hooks the primitives can be
+    replaced by defining ALL of the following:
+
+    DYN_ARRAY_THREAD, DYN_ARRAY_THREAD_CREATE(t, f, a) (non zero on success), DYN_ARRAY_THREAD_JOIN(t)
+    DYN_ARRAY_MUTEX, DYN_ARRAY_MUTEX_INIT(m), DYN_ARRAY_MUTEX_DESTROY(m), DYN_ARRAY_MUTEX_LOCK(m), DYN_ARRAY_MUTEX_UNLOCK(m)
+    DYN_ARRAY_CONDITION, DYN_ARRAY_CONDITION_INIT(c), DYN_ARRAY_CONDITION_DESTROY(c),
+    DYN_ARRAY_CONDITION_WAIT(c, m), DYN_ARRAY_CONDITION_BROADCAST(c)
+
+    and optionally DYN_ARRAY_CPU_COUNT() which sizes a pool created with 0 threads.
+
+    Example:
+    #define DYN_ARRAY_PARALLEL
+    #include "dyn_array.h"
+
+    pool = dyn_array_parallel_create(0);  // One thread per CPU
+    dyn_array_parallel_reduce(pool, myNumbers, sum_range, add_sums, &total, context);
+    dyn_array_parallel_destroy(pool);
+
+  #define DYN_ARRAY_CONCURRENT
+
+    Provides "dyn_array_concurrent", an append only array for many producer threads without a global lock.
+    Producers reserve slots with one atomic add and write their elements into segments which double in
+    size (the first holds DYN_ARRAY_CONCURRENT_FIRST elements, Default: 256) and never move. No producer
+    waits for another one. Readers can access the published prefix (the leading segments without pending
+    writes, everything once the producers are done) while producers keep adding.
+    "dyn_array_concurrent_to_array" copies the content into a regular dyn_array.
+
+    Example:
+    #define DYN_ARRAY_CONCURRENT
+    #include "dyn_array.h"
+
+    dyn_array_concurrent results;
+    dyn_array_concurrent_init(&results, sizeof(double));
+    dyn_array_concurrent_add(&results, &value);             // From any thread
+    dyn_array_concurrent_add_array(&results, values, 16);   // 16 consecutive slots
+    dyn_array_concurrent_to_array(&results, myNumbers);     // Published elements as a dyn_array
+    dyn_array_concurrent_free(&results);
+
+  #define DYN_ARRAY_SEGMENTED_BLOCK_BYTES
+
+    Block size of the segmented arrays (Default: 65536). Each block holds the largest power of two
+    number of elements fitting into it. Larger blocks mean fewer allocations and a smaller block table
+    for huge arrays, smaller blocks waste less memory for short ones (a segmented array always owns at
+    least one block).
+
+  #define DYN_ARRAY_SOA_ALIGNMENT
+
+    Alignment of every column of a struct of arrays container (Default: 64). Each column starts at
+    this boundary and its storage is rounded up to a multiple of it, so SIMD kernels can process a
+    column with aligned full width loads. Must be a power of two.
+
+  #define DYN_ARRAY_FILE
+
+    Provides a versioned binary file format for arrays: a 64 byte header (magic, version, endianness
+    tag, element size, length, alignment) followed by the raw elements at a "DYN_ARRAY_FILE_ALIGNMENT"
+    (Default: 4096) aligned offset. "dyn_array_save" writes an array, "dyn_array_load" reads it back
+    into a new array and "dyn_array_map" maps the file (copy on write) and uses it in place as a
+    dyn_array without reading or copying the elements. Files from a different element size, version
+    or byte order are rejected.
+
+    "dyn_array_persistent_open" keeps an array in a shared mapping of such a file: it is used like any
+    other array, growing extends the file instead of calling "DYN_ARRAY_FUNCTION_REALLOC" and
+    "dyn_array_persistent_flush" syncs it to disk. dyn_array_map and persistent arrays are not
+    available with "DYN_ARRAY_HEADER_COMPACT".
+
+    Example:
+    #define DYN_ARRAY_FILE
+    #include "dyn_array.h"
+
+    dyn_array_save(myNumbers, "numbers.bin");    // Returns 0 if writing fails
+    dyn_array_load(myNumbers, "numbers.bin");    // Returns 0 if the file is missing or does not match
+    dyn_array_map(myNumbers, "numbers.bin");     // Pages are read on first access
+    dyn_array_free(myNumbers);                   // Unmaps the file (dyn_array_unmap does the same)
+
+    dyn_array_persistent_open(events, "events.bin"); // Created if missing, returns 0 if it can not be opened
+    dyn_array_add(events, event);                    // Extends the file when the capacity is exhausted
+    dyn_array_persistent_flush(events);              // The elements added so far survive a crash
+    dyn_array_persistent_close(events);              // Flushes and closes the file (dyn_array_free does the same)
+
+  #define DYN_ARRAY_TRACE
+
+    Records every grow and free of a dyn_array with the __FILE__ and __LINE__
+    of the macro call, the element size, the length, the old and the new
+    capacity and a timestamp in a ring buffer of the last
+    DYN_ARRAY_TRACE_EVENTS (Default: 4096, 80 bytes each) events.
+    dyn_array_trace_dump writes it to a binary file (implies DYN_ARRAY_FILE)
+    which tests/dyn_array_replay.c replays against other growth factors and
+    allocator backends, reporting the realloc bytes and the peak memory of
+    each. Like the statistics there is one trace for the program, so a
+    program with several translation units defines DYN_ARRAY_GLOBALS_EXTERN
+    before the include in all of them but one.
+
+    Timestamps are cycle counter ticks on x86 and ARM64. Define
+    DYN_ARRAY_TRACE_CLOCK() and DYN_ARRAY_TRACE_CLOCK_FREQUENCY() (ticks per
+    second) to use another clock.
+
+    Example:
+    #define DYN_ARRAY_TRACE
+    #include "dyn_array.h"
+
+    dyn_array_trace_dump("grow.trace");      // Returns 0 if writing fails
+    dyn_array_trace_reset();                 // Drops the recorded events
+
   #define DYN_ARRAY_COLLECT_STATISTICS
 
     This global flag needs to be set if some statistics should be gathered
@@ -46,19 +261,80 @@ COMPILE-TIME OPTIONS
     dyn_array_stats_grow_with_factor
     dyn_array_stats_free
 
+    The counters are kept in a single dyn_array_stats for the program and
+    updated atomically, so threads may use arrays concurrently. The header
+    defines it, so a program with several translation units defines
+    DYN_ARRAY_GLOBALS_EXTERN before the include in all of them but one.
+    Besides the counts it tracks the bytes currently allocated and their peak, the
+    bytes copied by growing, the unused capacity of freed arrays and a log2
+    histogram of the sizes of freed arrays (dyn_array, deque and struct of
+    arrays allocations).
+
     Example:
     #define DYN_ARRAY_COLLECT_STATISTICS
+    #define DYN_ARRAY_GLOBALS_EXTERN                 // In all translation units but one
     #include "dyn_array.h"
 
+    dyn_array_stats stats;
+    dyn_array_stats_snapshot(&stats);        // Consistent per value while other threads keep running
+    dyn_array_stats_merge(&total, &stats);   // e.g. sums the snapshots of several processes
+    dyn_array_stats_reset();                 // Counters to 0, the peak restarts at the current bytes
+
 
 USAGE
 
    double *myNumbers = NULL;     // IMPORTANT: Always initialize!
    dyn_array_init(myNumbers, 8); // OPTIONAL: Initialize with initial capacity of 8 elements
 
+   dyn_array_usize storage[DYN_ARRAY_BUFFER_WORDS(double, 16)]; // OPTIONAL: header + 16 elements on the stack
+   dyn_array_init_buffer(myNumbers, storage, sizeof(storage));  // No allocation until the 17th element,
+                                                                // dyn_array_free never frees "storage"
+
    dyn_array_add(myNumbers, 42.0);
    dyn_array_add(myNumbers, 1337.0);
 
+   dyn_array_add_array(myNumbers, otherNumbers, 16); // Appends 16 elements with a single block copy
+
+   p = dyn_array_add_uninitialized(myNumbers, 64); // Writable space for 64 elements at the end (e.g. for read())
+   dyn_array_add_commit(myNumbers, produce(p, 64)); // Appends the number of elements actually written (<= 64)
+
+   dyn_array_insert(myNumbers, 0, 3.0);        // Inserts at index 0, the tail moves up by one element
+   dyn_array_erase_range(myNumbers, 1, 2);     // Removes elements 1 and 2 with a single block move
+   dyn_array_erase(myNumbers, 0);              // Removes element 0
+   dyn_array_swap_remove(myNumbers, 0);        // O(1): the last element replaces element 0 (order changes)
+
+   dyn_array_sort(myNumbers, compare);                          // Introsort with a qsort style comparator
+   dyn_array_radix_sort(myNumbers, scratch, DYN_ARRAY_KEY_FLOAT); // Stable radix sort, scratch is a reusable dyn_array
+   i = dyn_array_lower_bound(myNumbers, &key, compare);         // Binary search on the sorted array
+   dyn_array_union(result, myNumbers, otherNumbers, compare);   // New array, also merge/intersection/difference
+
+   dyn_array_filter(myNumbers, is_positive, context);           // Keeps the elements matching the predicate in place
+
+   double **blocks = NULL;                       // Segmented array: elements never move when it grows
+   dyn_array_segmented_add(blocks, 42.0);
+   p = &dyn_array_segmented_at(blocks, 0);       // Stays valid until dyn_array_segmented_free(blocks)
+
+   int *queue = NULL;                            // Deque (ring buffer), O(1) at both ends
+   dyn_array_deque_push_back(queue, 1);
+   dyn_array_deque_push_front(queue, 0);
+   x = dyn_array_deque_pop_front(queue);         // Also pop_back, front, back and dyn_array_deque_at(queue, i)
+   p = dyn_array_deque_first_span(queue);        // Zero-copy iteration: first_span_length elements at p,
+                                                 // then second_span_length elements at queue
+
+   #define POINT_FIELDS(X) X(float, x) X(float, y)   // Struct of arrays: one column per field, one allocation
+   DYN_ARRAY_SOA_DEFINE(points, POINT_FIELDS)      // At file scope, defines the "points" type and functions
+   points pts; points_init(&pts);
+   points_add(&pts, 1.0f, 2.0f);                 // One argument per field
+   f = pts.x;                                    // Column pointer, pts.length elements, 64 byte aligned
+   points_free(&pts);
+
+   dyn_array_reserve(myNumbers, 100);  // Capacity for at least 100 more elements without a realloc
+   dyn_array_add_unchecked(myNumbers, 1.0); // No capacity check, only valid within reserved capacity
+   dyn_array_resize(myNumbers, 50);    // Length 50, new elements are uninitialized
+   dyn_array_resize_zero(myNumbers, 60); // Length 60, new elements are zeroed
+   dyn_array_shrink_to_fit(myNumbers); // Capacity equals length
+   dyn_array_clear(myNumbers);         // Length 0, the storage is kept for reuse
+
     for (i = 0; i < dyn_array_length(myNumbers); ++i)
     {
         printf("%g\n", myNumbers[i]);
@@ -99,107 +375,4498 @@ LICENSE
 #define DYN_ARRAY_API static
 #endif
 
+/* Branch hints and out of line placement for the rarely taken grow path */
+#if defined(__GNUC__) || defined(__clang__)
+#define DYN_ARRAY_LIKELY(x) __builtin_expect(!!(x), 1)
+#define DYN_ARRAY_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#define DYN_ARRAY_NOINLINE __attribute__((noinline, unused))
+#elif defined(_MSC_VER)
+#define DYN_ARRAY_LIKELY(x) (x)
+#define DYN_ARRAY_UNLIKELY(x) (x)
+#define DYN_ARRAY_NOINLINE __declspec(noinline)
+#else
+#define DYN_ARRAY_LIKELY(x) (x)
+#define DYN_ARRAY_UNLIKELY(x) (x)
+#define DYN_ARRAY_NOINLINE
+#endif
+
+#define DYN_ARRAY_NULL ((void *)0)
+
+/* Pointer sized unsigned integer (size_t without including stddef.h) */
+#if defined(__GNUC__) || defined(__clang__)
+typedef __SIZE_TYPE__ dyn_array_usize;
+#elif defined(_WIN64)
+typedef unsigned __int64 dyn_array_usize;
+#else
+typedef unsigned long dyn_array_usize;
+#endif
+
+/* Type of the length and capacity of an array */
+#ifdef DYN_ARRAY_SIZE_T
+typedef dyn_array_usize dyn_array_size;
+#else
+typedef unsigned int dyn_array_size;
+#endif
+
+#define DYN_ARRAY_SIZE_MAX ((dyn_array_size)-1)
+#define DYN_ARRAY_USIZE_MAX ((dyn_array_usize)-1)
+
+/* Fixed width fields of the file and trace formats */
+#if defined(__GNUC__) || defined(__clang__)
+__extension__ typedef unsigned long long dyn_array_u64;
+#elif defined(_MSC_VER)
+typedef unsigned __int64 dyn_array_u64;
+#else
+typedef unsigned long dyn_array_u64; /* 64-bit on LP64 targets only */
+#endif
+
+#define DYN_ARRAY_GROW_FACTOR_1_5X(c) ((c) >> 1)
+#define DYN_ARRAY_GROW_FACTOR_2X(c) (c)
+#define DYN_ARRAY_GROW_FACTOR_GOLDEN(c) (((c) >> 1) + ((c) >> 3) - ((c) >> 7))
+
 #ifndef DYN_ARRAY_GROW_FACTOR_FUNCTION
-#define DYN_ARRAY_GROW_FACTOR_FUNCTION(c) ((c) * 1.5 - (c))
+#define DYN_ARRAY_GROW_FACTOR_FUNCTION(c) DYN_ARRAY_GROW_FACTOR_1_5X(c)
 #endif
 
+#ifndef DYN_ARRAY_PAGE_SIZE
+#define DYN_ARRAY_PAGE_SIZE 4096
+#endif
+
+#define dyn_array_round_up(v, a) (((v) + ((a) - 1)) & ~((dyn_array_usize)(a) - 1))
+#define DYN_ARRAY_GROW_ROUND_MALLOC(b) (dyn_array_round_up((b) + 8, 16) - 8)
+#define DYN_ARRAY_GROW_ROUND_PAGE(b) (dyn_array_round_up((b), DYN_ARRAY_PAGE_SIZE))
+#define DYN_ARRAY_GROW_ROUND_SIZE_CLASS(b) ((b) < DYN_ARRAY_PAGE_SIZE ? DYN_ARRAY_GROW_ROUND_MALLOC(b) : DYN_ARRAY_GROW_ROUND_PAGE(b))
+
 #if !defined(DYN_ARRAY_FUNCTION_REALLOC) && !defined(DYN_ARRAY_FUNCTION_FREE)
 #include <stdlib.h>
 #define DYN_ARRAY_FUNCTION_REALLOC(p, s) (realloc(p, s))
 #define DYN_ARRAY_FUNCTION_FREE(p) (free(p))
 #endif
 
-#ifdef DYN_ARRAY_COLLECT_STATISTICS
-#define DYN_ARRAY_STATS(x) x
+/* #############################################################################
+ * # MEMORY KERNELS
+ * #############################################################################
+ */
+/* Pointer sized word. may_alias allows to copy arbitrary element types through it */
+#if defined(__GNUC__) || defined(__clang__)
+typedef dyn_array_usize __attribute__((__may_alias__)) dyn_array_word;
+#else
+typedef dyn_array_usize dyn_array_word;
+#endif
 
-unsigned int dyn_array_stats_init;
-unsigned int dyn_array_stats_realloc;
-unsigned int dyn_array_stats_grow_with_factor;
-unsigned int dyn_array_stats_free;
+#define DYN_ARRAY_WORD_MASK (sizeof(dyn_array_word) - 1)
 
-DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_stats_reset(void)
+/* 32-bit word for copying 4 byte elements (int, float) on 64-bit targets */
+#if defined(__GNUC__) || defined(__clang__)
+typedef unsigned int __attribute__((__may_alias__)) dyn_array_word32;
+#else
+typedef unsigned int dyn_array_word32;
+#endif
+
+/* Freestanding block copy (no memcpy). Copies word wide if source and destination share the same word alignment */
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_memory_copy(void *destination, const void *source, dyn_array_usize size)
 {
-  dyn_array_stats_init = 0;
-  dyn_array_stats_realloc = 0;
-  dyn_array_stats_grow_with_factor = 0;
-  dyn_array_stats_free = 0;
+  unsigned char *d = (unsigned char *)destination;
+  const unsigned char *s = (const unsigned char *)source;
+
+  if ((((dyn_array_word)d ^ (dyn_array_word)s) & DYN_ARRAY_WORD_MASK) == 0)
+  {
+    dyn_array_word *dw;
+    const dyn_array_word *sw;
+
+    while (size && ((dyn_array_word)d & DYN_ARRAY_WORD_MASK))
+    {
+      *d++ = *s++;
+      --size;
+    }
+
+    dw = (dyn_array_word *)d;
+    sw = (const dyn_array_word *)s;
+
+    while (size >= 4 * sizeof(dyn_array_word))
+    {
+      dw[0] = sw[0];
+      dw[1] = sw[1];
+      dw[2] = sw[2];
+      dw[3] = sw[3];
+      dw += 4;
+      sw += 4;
+      size -= 4 * sizeof(dyn_array_word);
+    }
+
+    while (size >= sizeof(dyn_array_word))
+    {
+      *dw++ = *sw++;
+      size -= sizeof(dyn_array_word);
+    }
+
+    d = (unsigned char *)dw;
+    s = (const unsigned char *)sw;
+  }
+
+  while (size--)
+  {
+    *d++ = *s++;
+  }
 }
 
-#else
-#define DYN_ARRAY_STATS(x)
-#endif
+/* Freestanding overlapping block move (no memmove). Copies backwards if the destination lies behind the source */
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_memory_move(void *destination, const void *source, dyn_array_usize size)
+{
+  unsigned char *d = (unsigned char *)destination;
+  const unsigned char *s = (const unsigned char *)source;
 
-typedef struct dyn_array_header
+  if (d <= s || d >= s + size)
+  {
+    dyn_array_memory_copy(destination, source, size);
+    return;
+  }
+
+  d += size;
+  s += size;
+
+  if ((((dyn_array_word)d ^ (dyn_array_word)s) & DYN_ARRAY_WORD_MASK) == 0)
+  {
+    dyn_array_word *dw;
+    const dyn_array_word *sw;
+
+    while (size && ((dyn_array_word)d & DYN_ARRAY_WORD_MASK))
+    {
+      *--d = *--s;
+      --size;
+    }
+
+    dw = (dyn_array_word *)d;
+    sw = (const dyn_array_word *)s;
+
+    while (size >= sizeof(dyn_array_word))
+    {
+      *--dw = *--sw;
+      size -= sizeof(dyn_array_word);
+    }
+
+    d = (unsigned char *)dw;
+    s = (const unsigned char *)sw;
+  }
+
+  while (size--)
+  {
+    *--d = *--s;
+  }
+}
+
+/* Freestanding block zeroing (no memset) */
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_memory_zero(void *destination, dyn_array_usize size)
 {
-  unsigned int capacity;
-  unsigned int length;
-  void *data;
+  unsigned char *d = (unsigned char *)destination;
 
-} dyn_array_header;
+  while (size && ((dyn_array_word)d & DYN_ARRAY_WORD_MASK))
+  {
+    *d++ = 0;
+    --size;
+  }
 
-#define DYN_ARRAY_NULL ((void *)0)
-#define dyn_array_header(t) ((dyn_array_header *)(t) - 1)
-#define dyn_array_capacity(t) ((t) ? dyn_array_header(t)->capacity : 0)
-#define dyn_array_length(t) ((t) ? dyn_array_header(t)->length : 0)
+  {
+    dyn_array_word *dw = (dyn_array_word *)d;
+
+    while (size >= sizeof(dyn_array_word))
+    {
+      *dw++ = 0;
+      size -= sizeof(dyn_array_word);
+    }
+
+    d = (unsigned char *)dw;
+  }
+
+  while (size--)
+  {
+    *d++ = 0;
+  }
+}
 
-DYN_ARRAY_API DYN_ARRAY_INLINE void *dyn_array_grow_function(void *type, unsigned int type_size, unsigned int capacity, unsigned int add_length)
+/* Freestanding exchange of two non overlapping blocks */
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_memory_swap(void *a, void *b, dyn_array_usize size)
 {
-  void *b;
+  unsigned char *x = (unsigned char *)a;
+  unsigned char *y = (unsigned char *)b;
+  unsigned char t;
 
-  if (add_length > 0)
+  if (((((dyn_array_word)x | (dyn_array_word)y) & DYN_ARRAY_WORD_MASK) == 0))
   {
-    capacity += add_length + ((unsigned int)(DYN_ARRAY_GROW_FACTOR_FUNCTION(capacity)));
-    DYN_ARRAY_STATS(++dyn_array_stats_grow_with_factor);
+    dyn_array_word *xw = (dyn_array_word *)x;
+    dyn_array_word *yw = (dyn_array_word *)y;
+    dyn_array_word tw;
+
+    while (size >= sizeof(dyn_array_word))
+    {
+      tw = *xw;
+      *xw++ = *yw;
+      *yw++ = tw;
+      size -= sizeof(dyn_array_word);
+    }
+
+    x = (unsigned char *)xw;
+    y = (unsigned char *)yw;
   }
 
-  b = DYN_ARRAY_FUNCTION_REALLOC((type) ? dyn_array_header(type) : 0, type_size * capacity + sizeof(dyn_array_header));
+  while (size--)
+  {
+    t = *x;
+    *x++ = *y;
+    *y++ = t;
+  }
+}
 
-  if (!b)
+/* Copy of a single element. Pointer sized and 4 byte elements at their alignment take a single load and store */
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_memory_copy_element(void *destination, const void *source, dyn_array_usize size)
+{
+  if (size == sizeof(dyn_array_word) && ((((dyn_array_word)destination | (dyn_array_word)source) & DYN_ARRAY_WORD_MASK) == 0))
   {
-    return DYN_ARRAY_NULL;
+    *(dyn_array_word *)destination = *(const dyn_array_word *)source;
+  }
+  else if (size == sizeof(dyn_array_word32) && ((((dyn_array_word)destination | (dyn_array_word)source) & (sizeof(dyn_array_word32) - 1)) == 0))
+  {
+    *(dyn_array_word32 *)destination = *(const dyn_array_word32 *)source;
+  }
+  else
+  {
+    dyn_array_memory_copy(destination, source, size);
   }
+}
 
-  b = (char *)b + sizeof(dyn_array_header);
+/* Index of the highest set bit, v > 0. Folds to a constant for constant arguments */
+DYN_ARRAY_API DYN_ARRAY_INLINE unsigned int dyn_array_log2(dyn_array_usize v)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return sizeof(dyn_array_usize) > sizeof(unsigned long) ? 63u - (unsigned int)__builtin_clzll(v) : (unsigned int)(sizeof(unsigned long) * 8 - 1) - (unsigned int)__builtin_clzl((unsigned long)v);
+#else
+  unsigned int r = 0;
+  while (v >>= 1)
+  {
+    ++r;
+  }
+  return r;
+#endif
+}
 
-  DYN_ARRAY_STATS(++dyn_array_stats_realloc);
+/* #############################################################################
+ * # ATOMICS
+ * #############################################################################
+ */
+#if defined(DYN_ARRAY_PARALLEL) || defined(DYN_ARRAY_CONCURRENT) || defined(DYN_ARRAY_COLLECT_STATISTICS) || defined(DYN_ARRAY_TRACE)
 
-  if (type == DYN_ARRAY_NULL)
+/* Atomics on dyn_array_usize: add returning the previous value (acquire/release), acquire load (also on
+   pointers) and compare and swap (dyn_array_usize and pointers) which evaluates to non zero on success */
+#if defined(__GNUC__) || defined(__clang__)
+#define DYN_ARRAY_ATOMIC_FETCH_ADD(p, v) (__atomic_fetch_add((p), (v), __ATOMIC_ACQ_REL))
+#define DYN_ARRAY_ATOMIC_LOAD(p) (__atomic_load_n((p), __ATOMIC_ACQUIRE))
+#define DYN_ARRAY_ATOMIC_CAS(p, expected, desired) (__sync_bool_compare_and_swap((p), (expected), (desired)))
+#define DYN_ARRAY_ATOMIC_CAS_POINTER(p, expected, desired) (__sync_bool_compare_and_swap((p), (expected), (desired)))
+#elif defined(_MSC_VER)
+/* volatile loads have acquire semantics with the default /volatile:ms */
+void *_InterlockedCompareExchangePointer(void *volatile *destination, void *exchange, void *comparand);
+#pragma intrinsic(_InterlockedCompareExchangePointer)
+#if defined(_WIN64)
+__int64 _InterlockedExchangeAdd64(__int64 volatile *addend, __int64 value);
+__int64 _InterlockedCompareExchange64(__int64 volatile *destination, __int64 exchange, __int64 comparand);
+#pragma intrinsic(_InterlockedExchangeAdd64)
+#pragma intrinsic(_InterlockedCompareExchange64)
+#define DYN_ARRAY_ATOMIC_FETCH_ADD(p, v) ((dyn_array_usize)_InterlockedExchangeAdd64((__int64 volatile *)(p), (__int64)(v)))
+#define DYN_ARRAY_ATOMIC_CAS(p, expected, desired) (_InterlockedCompareExchange64((__int64 volatile *)(p), (__int64)(desired), (__int64)(expected)) == (__int64)(expected))
+#else
+long _InterlockedExchangeAdd(long volatile *addend, long value);
+long _InterlockedCompareExchange(long volatile *destination, long exchange, long comparand);
+#pragma intrinsic(_InterlockedExchangeAdd)
+#pragma intrinsic(_InterlockedCompareExchange)
+#define DYN_ARRAY_ATOMIC_FETCH_ADD(p, v) ((dyn_array_usize)_InterlockedExchangeAdd((long volatile *)(p), (long)(v)))
+#define DYN_ARRAY_ATOMIC_CAS(p, expected, desired) (_InterlockedCompareExchange((long volatile *)(p), (long)(desired), (long)(expected)) == (long)(expected))
+#endif
+#define DYN_ARRAY_ATOMIC_LOAD(p) (*(p))
+#define DYN_ARRAY_ATOMIC_CAS_POINTER(p, expected, desired) (_InterlockedCompareExchangePointer((void *volatile *)(p), (desired), (expected)) == (expected))
+#elif defined(DYN_ARRAY_PARALLEL) || defined(DYN_ARRAY_CONCURRENT)
+#error "DYN_ARRAY_PARALLEL and DYN_ARRAY_CONCURRENT need atomics which are not available for this compiler"
+#else
+/* Statistics and trace only: plain operations, correct as long as a single thread uses the library */
+#define DYN_ARRAY_ATOMIC_FETCH_ADD(p, v) ((*(p) += (v)) - (v))
+#define DYN_ARRAY_ATOMIC_LOAD(p) (*(p))
+#define DYN_ARRAY_ATOMIC_CAS(p, expected, desired) (*(p) == (expected) ? (*(p) = (desired), 1) : 0)
+#endif
+
+#endif /* DYN_ARRAY_PARALLEL || DYN_ARRAY_CONCURRENT || DYN_ARRAY_COLLECT_STATISTICS || DYN_ARRAY_TRACE */
+
+/* #############################################################################
+ * # STATISTICS
+ * #############################################################################
+ */
+#ifdef DYN_ARRAY_COLLECT_STATISTICS
+#define DYN_ARRAY_STATS(x) x
+#define DYN_ARRAY_STATS_ADD(counter, n) ((void)DYN_ARRAY_ATOMIC_FETCH_ADD(&dyn_array_stats_global.counter, (dyn_array_usize)(n)))
+
+/* Histogram bucket k counts the freed arrays holding [2^k, 2^(k+1)) bytes of elements, bucket 0 also the empty ones */
+#define DYN_ARRAY_STATS_BUCKETS 64
+
+typedef struct dyn_array_stats
+{
+  dyn_array_usize inits;             /* Arrays created */
+  dyn_array_usize reallocs;          /* Calls of DYN_ARRAY_FUNCTION_REALLOC */
+  dyn_array_usize grows;             /* Grows which applied the growth factor */
+  dyn_array_usize frees;             /* Blocks released by DYN_ARRAY_FUNCTION_FREE */
+  dyn_array_usize bytes;             /* Currently allocated, headers and alignment padding included */
+  dyn_array_usize bytes_peak;        /* Highest value of bytes */
+  dyn_array_usize bytes_copied;      /* Moved by reallocs which returned a new address and by grows which copy */
+  dyn_array_usize bytes_slack;       /* Unused capacity in bytes of the arrays when they were freed */
+  dyn_array_usize histogram[DYN_ARRAY_STATS_BUCKETS]; /* Freed arrays by the bytes of their elements */
+
+} dyn_array_stats;
+
+/* One instance for the whole program so arrays may be allocated and freed in different translation units.
+   Every translation unit but the one holding it defines DYN_ARRAY_GLOBALS_EXTERN before the include */
+extern dyn_array_stats dyn_array_stats_global;
+#ifndef DYN_ARRAY_GLOBALS_EXTERN
+dyn_array_stats dyn_array_stats_global;
+#endif
+
+/* The counters of previous versions */
+#define dyn_array_stats_init (dyn_array_stats_global.inits)
+#define dyn_array_stats_realloc (dyn_array_stats_global.reallocs)
+#define dyn_array_stats_grow_with_factor (dyn_array_stats_global.grows)
+#define dyn_array_stats_free (dyn_array_stats_global.frees)
+
+/* A block of "old_bytes" (0 for a new one) was replaced by one of "new_bytes" */
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_stats_allocated(dyn_array_usize old_bytes, dyn_array_usize new_bytes)
+{
+  dyn_array_usize bytes = DYN_ARRAY_ATOMIC_FETCH_ADD(&dyn_array_stats_global.bytes, new_bytes - old_bytes) + (new_bytes - old_bytes);
+  dyn_array_usize peak = DYN_ARRAY_ATOMIC_LOAD(&dyn_array_stats_global.bytes_peak);
+
+  while (bytes > peak && !DYN_ARRAY_ATOMIC_CAS(&dyn_array_stats_global.bytes_peak, peak, bytes))
   {
-    dyn_array_header(b)->length = 0;
-    dyn_array_header(b)->data = 0;
+    peak = DYN_ARRAY_ATOMIC_LOAD(&dyn_array_stats_global.bytes_peak);
+  }
+}
+
+/* A block of "bytes" holding "used" bytes of elements and "unused" bytes of capacity was freed */
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_stats_freed(dyn_array_usize bytes, dyn_array_usize used, dyn_array_usize unused)
+{
+  DYN_ARRAY_STATS_ADD(bytes, (dyn_array_usize)0 - bytes);
+  DYN_ARRAY_STATS_ADD(bytes_slack, unused);
+  DYN_ARRAY_STATS_ADD(histogram[used ? dyn_array_log2(used) : 0], 1);
+}
 
-    DYN_ARRAY_STATS(++dyn_array_stats_init);
+/* Copies the statistics, each value is read atomically */
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_stats_snapshot(dyn_array_stats *snapshot)
+{
+  const dyn_array_stats *source = &dyn_array_stats_global;
+  unsigned int i;
+
+  snapshot->inits = DYN_ARRAY_ATOMIC_LOAD(&source->inits);
+  snapshot->reallocs = DYN_ARRAY_ATOMIC_LOAD(&source->reallocs);
+  snapshot->grows = DYN_ARRAY_ATOMIC_LOAD(&source->grows);
+  snapshot->frees = DYN_ARRAY_ATOMIC_LOAD(&source->frees);
+  snapshot->bytes = DYN_ARRAY_ATOMIC_LOAD(&source->bytes);
+  snapshot->bytes_peak = DYN_ARRAY_ATOMIC_LOAD(&source->bytes_peak);
+  snapshot->bytes_copied = DYN_ARRAY_ATOMIC_LOAD(&source->bytes_copied);
+  snapshot->bytes_slack = DYN_ARRAY_ATOMIC_LOAD(&source->bytes_slack);
+
+  for (i = 0; i < DYN_ARRAY_STATS_BUCKETS; ++i)
+  {
+    snapshot->histogram[i] = DYN_ARRAY_ATOMIC_LOAD(&source->histogram[i]);
   }
+}
 
-  dyn_array_header(b)->capacity = capacity;
+/* Adds "snapshot" to "total", e.g. for the snapshots of several processes or runs. The peaks add up
+   to an upper bound of the combined peak */
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_stats_merge(dyn_array_stats *total, const dyn_array_stats *snapshot)
+{
+  unsigned int i;
 
-  return (b);
+  total->inits += snapshot->inits;
+  total->reallocs += snapshot->reallocs;
+  total->grows += snapshot->grows;
+  total->frees += snapshot->frees;
+  total->bytes += snapshot->bytes;
+  total->bytes_peak += snapshot->bytes_peak;
+  total->bytes_copied += snapshot->bytes_copied;
+  total->bytes_slack += snapshot->bytes_slack;
+
+  for (i = 0; i < DYN_ARRAY_STATS_BUCKETS; ++i)
+  {
+    total->histogram[i] += snapshot->histogram[i];
+  }
 }
 
-DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_free_function(dyn_array_header *type)
+/* Each counter drops atomically by the value read, so counts added by other threads meanwhile are kept */
+#define DYN_ARRAY_STATS_CLEAR(counter) DYN_ARRAY_STATS_ADD(counter, (dyn_array_usize)0 - DYN_ARRAY_ATOMIC_LOAD(&dyn_array_stats_global.counter))
+
+/* Clears the counters, also while other threads use arrays. The allocated bytes stay since the arrays do, the
+   peak restarts from them */
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_stats_reset(void)
 {
-  DYN_ARRAY_STATS(++dyn_array_stats_free);
-  DYN_ARRAY_FUNCTION_FREE(type);
+  dyn_array_usize bytes = DYN_ARRAY_ATOMIC_LOAD(&dyn_array_stats_global.bytes);
+  dyn_array_usize peak = DYN_ARRAY_ATOMIC_LOAD(&dyn_array_stats_global.bytes_peak);
+  unsigned int i;
+
+  DYN_ARRAY_STATS_CLEAR(inits);
+  DYN_ARRAY_STATS_CLEAR(reallocs);
+  DYN_ARRAY_STATS_CLEAR(grows);
+  DYN_ARRAY_STATS_CLEAR(frees);
+  DYN_ARRAY_STATS_CLEAR(bytes_copied);
+  DYN_ARRAY_STATS_CLEAR(bytes_slack);
+
+  for (i = 0; i < DYN_ARRAY_STATS_BUCKETS; ++i)
+  {
+    DYN_ARRAY_STATS_CLEAR(histogram[i]);
+  }
+
+  while (!DYN_ARRAY_ATOMIC_CAS(&dyn_array_stats_global.bytes_peak, peak, bytes))
+  {
+    peak = DYN_ARRAY_ATOMIC_LOAD(&dyn_array_stats_global.bytes_peak);
+  }
 }
 
-#define dyn_array_grow(t, c, n) ((t) = dyn_array_grow_function((t), sizeof *(t), (c), (n)))
-#define dyn_array_grow_check(t, n) ((!(t) || dyn_array_header(t)->length + (n) > dyn_array_header(t)->capacity) ? (dyn_array_grow(t, dyn_array_capacity(t), n), 0) : 0)
+#else
+#define DYN_ARRAY_STATS(x)
+#define DYN_ARRAY_STATS_ADD(counter, n)
+#endif
+
+/* #############################################################################
+ * # TRACING
+ * #############################################################################
+ */
+#ifdef DYN_ARRAY_TRACE
+
+/* Events kept in the ring, older ones are overwritten. Threads which grow arrays while the ring wraps around may
+   overwrite the same event, keep it larger than the events recorded during a dump interval */
+#ifndef DYN_ARRAY_TRACE_EVENTS
+#define DYN_ARRAY_TRACE_EVENTS 4096
+#endif
+
+/* Distinct __FILE__ names of call sites, sites in further files are recorded without a file */
+#ifndef DYN_ARRAY_TRACE_FILES
+#define DYN_ARRAY_TRACE_FILES 64
+#endif
+
+#if ((DYN_ARRAY_TRACE_EVENTS) & ((DYN_ARRAY_TRACE_EVENTS) - 1)) || (DYN_ARRAY_TRACE_EVENTS) < 1
+#error "DYN_ARRAY_TRACE_EVENTS has to be a power of two"
+#endif
+
+/* Timestamps: the cycle counter where it can be read without the OS. Define both to use another clock */
+#ifndef DYN_ARRAY_TRACE_CLOCK
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+DYN_ARRAY_API DYN_ARRAY_INLINE dyn_array_u64 dyn_array_trace_clock(void)
+{
+  unsigned int lo, hi;
+  __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+  return ((dyn_array_u64)hi << 32) | lo;
+}
+#define DYN_ARRAY_TRACE_CLOCK() dyn_array_trace_clock()
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__)
+DYN_ARRAY_API DYN_ARRAY_INLINE dyn_array_u64 dyn_array_trace_clock(void)
+{
+  dyn_array_u64 ticks;
+  __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(ticks));
+  return ticks;
+}
+DYN_ARRAY_API DYN_ARRAY_INLINE dyn_array_u64 dyn_array_trace_clock_frequency(void)
+{
+  dyn_array_u64 frequency;
+  __asm__ __volatile__("mrs %0, cntfrq_el0" : "=r"(frequency));
+  return frequency;
+}
+#define DYN_ARRAY_TRACE_CLOCK() dyn_array_trace_clock()
+#define DYN_ARRAY_TRACE_CLOCK_FREQUENCY() dyn_array_trace_clock_frequency()
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+unsigned __int64 __rdtsc(void);
+#pragma intrinsic(__rdtsc)
+#define DYN_ARRAY_TRACE_CLOCK() ((dyn_array_u64)__rdtsc())
+#else
+#define DYN_ARRAY_TRACE_CLOCK() ((dyn_array_u64)0)
+#endif
+#endif
+
+/* Ticks per second of DYN_ARRAY_TRACE_CLOCK, 0 if unknown (the TSC rate is not exposed to user space) */
+#ifndef DYN_ARRAY_TRACE_CLOCK_FREQUENCY
+#define DYN_ARRAY_TRACE_CLOCK_FREQUENCY() ((dyn_array_u64)0)
+#endif
+
+/* The call site is passed from the macros down to the grow and free functions as two trailing arguments. No thread
+   local storage is involved, which the nostdlib Win32 build could not provide */
+#define DYN_ARRAY_TRACE_SITE_PARAMETERS , const char *site_file, int site_line
+#define DYN_ARRAY_TRACE_SITE_ARGUMENTS , site_file, site_line
+#define DYN_ARRAY_TRACE_SITE_HERE , __FILE__, __LINE__
+#define DYN_ARRAY_TRACE_SITE_NONE , (const char *)DYN_ARRAY_NULL, 0
+
+#define DYN_ARRAY_TRACE_GROW 1u
+#define DYN_ARRAY_TRACE_FREE 2u
+#define DYN_ARRAY_TRACE_NO_FILE 0xFFFFFFFFu
+
+/* 80 bytes, written as is by dyn_array_trace_dump */
+typedef struct dyn_array_trace_event
+{
+  dyn_array_u64 timestamp;    /* DYN_ARRAY_TRACE_CLOCK() */
+  dyn_array_u64 array;        /* Address of the elements before the event, 0 for a new array */
+  dyn_array_u64 moved;        /* Address of the elements after the event, 0 for a free */
+  dyn_array_u64 length;       /* Length before the event */
+  dyn_array_u64 requested;    /* Capacity argument of dyn_array_grow_function */
+  dyn_array_u64 add_length;   /* Elements to add: the growth factor applied. 0: "requested" is the exact capacity */
+  dyn_array_u64 old_capacity; /* 0 for a new array */
+  dyn_array_u64 new_capacity; /* 0 for a free */
+  unsigned int type_size;
+  unsigned int kind; /* DYN_ARRAY_TRACE_GROW or DYN_ARRAY_TRACE_FREE */
+  unsigned int file; /* Index into the file names, DYN_ARRAY_TRACE_NO_FILE for calls within the library */
+  unsigned int line;
+
+} dyn_array_trace_event;
+
+typedef struct dyn_array_trace
+{
+  dyn_array_usize recorded; /* Events so far, the ring keeps the last DYN_ARRAY_TRACE_EVENTS */
+  const char *files[DYN_ARRAY_TRACE_FILES];
+  dyn_array_trace_event events[DYN_ARRAY_TRACE_EVENTS];
+
+} dyn_array_trace;
+
+/* One instance for the whole program like the statistics, so an array grown in one translation unit and freed in
+   another shows up in a single dump */
+extern dyn_array_trace dyn_array_trace_global;
+#ifndef DYN_ARRAY_GLOBALS_EXTERN
+dyn_array_trace dyn_array_trace_global;
+#endif
+
+DYN_ARRAY_API DYN_ARRAY_INLINE int dyn_array_trace_file_equal(const char *a, const char *b)
+{
+  while (*a && *a == *b)
+  {
+    a++;
+    b++;
+  }
+
+  return *a == *b;
+}
+
+/* Index of "file" in the file names, registered on first use. Identical __FILE__ literals are not guaranteed to be
+   merged, so a name which is not found by its address is compared by its characters before it takes a new slot */
+DYN_ARRAY_API DYN_ARRAY_INLINE unsigned int dyn_array_trace_file_index(const char *file)
+{
+  const char *known;
+  unsigned int i;
+
+  /* The names fill the slots in order, the first empty one ends the search */
+  for (i = 0; file && i < DYN_ARRAY_TRACE_FILES; ++i)
+  {
+    known = DYN_ARRAY_ATOMIC_LOAD(&dyn_array_trace_global.files[i]);
+
+    if (known == file)
+    {
+      return i;
+    }
+
+    if (!known)
+    {
+      break;
+    }
+  }
+
+  for (i = 0; file && i < DYN_ARRAY_TRACE_FILES; ++i)
+  {
+    known = DYN_ARRAY_ATOMIC_LOAD(&dyn_array_trace_global.files[i]);
+
+    if (!known && DYN_ARRAY_ATOMIC_CAS_POINTER(&dyn_array_trace_global.files[i], DYN_ARRAY_NULL, file))
+    {
+      return i;
+    }
+
+    if (dyn_array_trace_file_equal(DYN_ARRAY_ATOMIC_LOAD(&dyn_array_trace_global.files[i]), file))
+    {
+      return i;
+    }
+  }
+
+  return DYN_ARRAY_TRACE_NO_FILE;
+}
+
+/* Called by the grow and free functions with the call site of the macro which led there, NULL for calls within the library */
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_trace_record(unsigned int kind, const char *file, int line, dyn_array_usize type_size, dyn_array_usize array, dyn_array_usize moved,
+                                                           dyn_array_usize length, dyn_array_usize requested, dyn_array_usize add_length, dyn_array_usize old_capacity,
+                                                           dyn_array_usize new_capacity)
+{
+  dyn_array_usize index = DYN_ARRAY_ATOMIC_FETCH_ADD(&dyn_array_trace_global.recorded, 1);
+  dyn_array_trace_event *event = &dyn_array_trace_global.events[index & (DYN_ARRAY_TRACE_EVENTS - 1)];
+
+  event->timestamp = DYN_ARRAY_TRACE_CLOCK();
+  event->array = array;
+  event->moved = moved;
+  event->length = length;
+  event->requested = requested;
+  event->add_length = add_length;
+  event->old_capacity = old_capacity;
+  event->new_capacity = new_capacity;
+  event->type_size = (unsigned int)type_size;
+  event->kind = kind;
+  event->file = dyn_array_trace_file_index(file);
+  event->line = file ? (unsigned int)line : 0;
+}
+
+/* Drops the recorded events, e.g. after a warm up phase */
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_trace_reset(void)
+{
+  dyn_array_trace_global.recorded = 0;
+}
+
+#else
+#define DYN_ARRAY_TRACE_SITE_PARAMETERS
+#define DYN_ARRAY_TRACE_SITE_ARGUMENTS
+#define DYN_ARRAY_TRACE_SITE_HERE
+#define DYN_ARRAY_TRACE_SITE_NONE
+#endif
+
+/* #############################################################################
+ * # PLATFORM
+ * #############################################################################
+ */
+/* The trace is dumped through the file functions */
+#if defined(DYN_ARRAY_TRACE) && !defined(DYN_ARRAY_FILE)
+#define DYN_ARRAY_FILE
+#endif
+
+#if defined(DYN_ARRAY_VIRTUAL_MEMORY) || defined(DYN_ARRAY_MREMAP) || defined(DYN_ARRAY_FILE)
+#define DYN_ARRAY_PLATFORM
+#endif
+
+#ifdef DYN_ARRAY_PLATFORM
+#ifdef _WIN32
+/* Windows prototypes since include windows.h is immensily slow !!! */
+#if defined(_WIN64)
+#define DYN_ARRAY_WINAPI
+#else
+#define DYN_ARRAY_WINAPI __stdcall
+#endif
+#define DYN_ARRAY_MEM_COMMIT 0x00001000
+#define DYN_ARRAY_MEM_RESERVE 0x00002000
+#define DYN_ARRAY_MEM_RELEASE 0x00008000
+#define DYN_ARRAY_PAGE_NOACCESS 0x01
+#define DYN_ARRAY_PAGE_READWRITE 0x04
+void *DYN_ARRAY_WINAPI VirtualAlloc(void *lpAddress, dyn_array_usize dwSize, unsigned long flAllocationType, unsigned long flProtect);
+int DYN_ARRAY_WINAPI VirtualFree(void *lpAddress, dyn_array_usize dwSize, unsigned long dwFreeType);
+#ifdef DYN_ARRAY_FILE
+#define DYN_ARRAY_GENERIC_READ 0x80000000UL
+#define DYN_ARRAY_GENERIC_WRITE 0x40000000UL
+#define DYN_ARRAY_FILE_SHARE_READ 0x00000001
+#define DYN_ARRAY_CREATE_ALWAYS 2
+#define DYN_ARRAY_OPEN_EXISTING 3
+#define DYN_ARRAY_FILE_ATTRIBUTE_NORMAL 0x00000080
+#define DYN_ARRAY_FILE_BEGIN 0
+#define DYN_ARRAY_INVALID_HANDLE_VALUE ((void *)-1)
+#define DYN_ARRAY_INVALID_SET_FILE_POINTER 0xFFFFFFFFUL
+#define DYN_ARRAY_PAGE_WRITECOPY 0x08
+#define DYN_ARRAY_OPEN_ALWAYS 4
+#define DYN_ARRAY_FILE_MAP_COPY 0x0001
+#define DYN_ARRAY_FILE_MAP_WRITE 0x0002
+void *DYN_ARRAY_WINAPI CreateFileA(const char *lpFileName, unsigned long dwDesiredAccess, unsigned long dwShareMode, void *lpSecurityAttributes, unsigned long dwCreationDisposition, unsigned long dwFlagsAndAttributes, void *hTemplateFile);
+int DYN_ARRAY_WINAPI ReadFile(void *hFile, void *lpBuffer, unsigned long nNumberOfBytesToRead, unsigned long *lpNumberOfBytesRead, void *lpOverlapped);
+int DYN_ARRAY_WINAPI WriteFile(void *hFile, const void *lpBuffer, unsigned long nNumberOfBytesToWrite, unsigned long *lpNumberOfBytesWritten, void *lpOverlapped);
+unsigned long DYN_ARRAY_WINAPI GetFileSize(void *hFile, unsigned long *lpFileSizeHigh);
+unsigned long DYN_ARRAY_WINAPI SetFilePointer(void *hFile, long lDistanceToMove, long *lpDistanceToMoveHigh, unsigned long dwMoveMethod);
+int DYN_ARRAY_WINAPI CloseHandle(void *hObject);
+void *DYN_ARRAY_WINAPI CreateFileMappingA(void *hFile, void *lpFileMappingAttributes, unsigned long flProtect, unsigned long dwMaximumSizeHigh, unsigned long dwMaximumSizeLow, const char *lpName);
+void *DYN_ARRAY_WINAPI MapViewOfFile(void *hFileMappingObject, unsigned long dwDesiredAccess, unsigned long dwFileOffsetHigh, unsigned long dwFileOffsetLow, dyn_array_usize dwNumberOfBytesToMap);
+int DYN_ARRAY_WINAPI UnmapViewOfFile(const void *lpBaseAddress);
+int DYN_ARRAY_WINAPI FlushViewOfFile(const void *lpBaseAddress, dyn_array_usize dwNumberOfBytesToFlush);
+int DYN_ARRAY_WINAPI FlushFileBuffers(void *hFile);
+int DYN_ARRAY_WINAPI SetEndOfFile(void *hFile);
+#endif
+#else
+/* POSIX prototypes so no libc header has to be pulled in */
+#define DYN_ARRAY_PROT_NONE 0x0
+#define DYN_ARRAY_PROT_READ 0x1
+#define DYN_ARRAY_PROT_WRITE 0x2
+#define DYN_ARRAY_MAP_PRIVATE 0x02
+#ifdef __APPLE__
+#define DYN_ARRAY_MAP_ANONYMOUS 0x1000
+#define DYN_ARRAY_MAP_NORESERVE 0x40
+#else
+#define DYN_ARRAY_MAP_ANONYMOUS 0x20
+#define DYN_ARRAY_MAP_NORESERVE 0x4000
+#endif
+#define DYN_ARRAY_MAP_FAILED ((void *)-1)
+/* off_t: "long long" on macOS, "long" on the other supported systems. Has to match <unistd.h> and <sys/mman.h>
+   exactly since the application (or DYN_ARRAY_PARALLEL) may include them as well */
+#ifdef __APPLE__
+__extension__ typedef long long dyn_array_off;
+#else
+typedef long dyn_array_off;
+#endif
+void *mmap(void *addr, dyn_array_usize length, int prot, int flags, int fd, dyn_array_off offset);
+int munmap(void *addr, dyn_array_usize length);
+int mprotect(void *addr, dyn_array_usize length, int prot);
+#ifdef __linux__
+#define DYN_ARRAY_MREMAP_MAYMOVE 1
+void *mremap(void *old_address, dyn_array_usize old_size, dyn_array_usize new_size, int flags, ...);
+#endif
+#ifdef DYN_ARRAY_FILE
+#define DYN_ARRAY_O_RDONLY 0x0
+#define DYN_ARRAY_O_WRONLY 0x1
+#define DYN_ARRAY_O_RDWR 0x2
+#define DYN_ARRAY_MAP_SHARED 0x01
+#ifdef __APPLE__
+#define DYN_ARRAY_O_CREAT 0x200
+#define DYN_ARRAY_O_TRUNC 0x400
+#define DYN_ARRAY_MS_SYNC 0x10
+#else
+#define DYN_ARRAY_O_CREAT 0x40
+#define DYN_ARRAY_O_TRUNC 0x200
+#define DYN_ARRAY_MS_SYNC 0x4
+#endif
+#define DYN_ARRAY_SEEK_SET 0
+#define DYN_ARRAY_SEEK_END 2
+#ifdef __PTRDIFF_TYPE__
+typedef __PTRDIFF_TYPE__ dyn_array_ssize;
+#else
+typedef long dyn_array_ssize;
+#endif
+int open(const char *path, int flags, ...);
+int close(int fd);
+dyn_array_ssize read(int fd, void *buffer, dyn_array_usize count);
+dyn_array_ssize write(int fd, const void *buffer, dyn_array_usize count);
+dyn_array_off lseek(int fd, dyn_array_off offset, int whence);
+int ftruncate(int fd, dyn_array_off length);
+int msync(void *addr, dyn_array_usize length, int flags);
+#endif
+#endif
+#endif /* DYN_ARRAY_PLATFORM */
+
+/* #############################################################################
+ * # VIRTUAL MEMORY BACKEND (reserve then commit)
+ * #############################################################################
+ */
+#ifdef DYN_ARRAY_VIRTUAL_MEMORY
+
+/* Address space reserved per array. Only committed pages are backed by memory */
+#ifndef DYN_ARRAY_VM_RESERVE_SIZE
+#if defined(_WIN64) || (defined(__SIZEOF_POINTER__) && __SIZEOF_POINTER__ >= 8)
+#define DYN_ARRAY_VM_RESERVE_SIZE ((dyn_array_usize)64 * 1024 * 1024 * 1024)
+#else
+#define DYN_ARRAY_VM_RESERVE_SIZE ((dyn_array_usize)256 * 1024 * 1024)
+#endif
+#endif
+
+/* Commit granularity. Multiple of the 4K/16K/64K page sizes in use */
+#ifndef DYN_ARRAY_VM_COMMIT_SIZE
+#define DYN_ARRAY_VM_COMMIT_SIZE ((dyn_array_usize)64 * 1024)
+#endif
+
+#ifdef _WIN32
+DYN_ARRAY_API DYN_ARRAY_INLINE void *dyn_array_vm_reserve(dyn_array_usize size)
+{
+  return VirtualAlloc(DYN_ARRAY_NULL, size, DYN_ARRAY_MEM_RESERVE, DYN_ARRAY_PAGE_NOACCESS);
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE int dyn_array_vm_commit(void *address, dyn_array_usize size)
+{
+  return VirtualAlloc(address, size, DYN_ARRAY_MEM_COMMIT, DYN_ARRAY_PAGE_READWRITE) != DYN_ARRAY_NULL;
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_vm_release(void *address, dyn_array_usize size)
+{
+  (void)size;
+  VirtualFree(address, 0, DYN_ARRAY_MEM_RELEASE);
+}
+#else
+DYN_ARRAY_API DYN_ARRAY_INLINE void *dyn_array_vm_reserve(dyn_array_usize size)
+{
+  void *address = mmap(DYN_ARRAY_NULL, size, DYN_ARRAY_PROT_NONE, DYN_ARRAY_MAP_PRIVATE | DYN_ARRAY_MAP_ANONYMOUS | DYN_ARRAY_MAP_NORESERVE, -1, 0);
+  return address == DYN_ARRAY_MAP_FAILED ? DYN_ARRAY_NULL : address;
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE int dyn_array_vm_commit(void *address, dyn_array_usize size)
+{
+  return mprotect(address, size, DYN_ARRAY_PROT_READ | DYN_ARRAY_PROT_WRITE) == 0;
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_vm_release(void *address, dyn_array_usize size)
+{
+  munmap(address, size);
+}
+#endif
+
+/* Stored at the start of every reservation, directly in front of the pointer handed to dyn_array */
+typedef struct dyn_array_vm_block
+{
+  dyn_array_usize reserved;
+  dyn_array_usize committed;
+
+} dyn_array_vm_block;
+
+/* realloc compatible. Growth within the reservation commits the new pages in place and never moves the memory.
+   Only if the reservation is exhausted a new, twice as large range is reserved and the content is copied once. */
+DYN_ARRAY_API DYN_ARRAY_INLINE void *dyn_array_vm_realloc(void *pointer, dyn_array_usize size)
+{
+  dyn_array_vm_block *block;
+  dyn_array_usize needed = dyn_array_round_up(size + sizeof(dyn_array_vm_block), DYN_ARRAY_VM_COMMIT_SIZE);
+  dyn_array_usize reserve = DYN_ARRAY_VM_RESERVE_SIZE;
+
+  if (pointer)
+  {
+    block = (dyn_array_vm_block *)pointer - 1;
+
+    if (needed <= block->committed)
+    {
+      return pointer;
+    }
+
+    if (needed <= block->reserved)
+    {
+      if (!dyn_array_vm_commit((char *)block + block->committed, needed - block->committed))
+      {
+        return DYN_ARRAY_NULL;
+      }
+
+      block->committed = needed;
+      return pointer;
+    }
+
+    reserve = block->reserved;
+  }
+
+  while (reserve < needed)
+  {
+    reserve *= 2;
+  }
+
+  block = (dyn_array_vm_block *)dyn_array_vm_reserve(reserve);
+
+  if (!block)
+  {
+    return DYN_ARRAY_NULL;
+  }
+
+  if (!dyn_array_vm_commit(block, needed))
+  {
+    dyn_array_vm_release(block, reserve);
+    return DYN_ARRAY_NULL;
+  }
+
+  block->reserved = reserve;
+  block->committed = needed;
+
+  if (pointer)
+  {
+    dyn_array_vm_block *old = (dyn_array_vm_block *)pointer - 1;
+    dyn_array_memory_copy(block + 1, pointer, old->committed - sizeof(dyn_array_vm_block));
+    dyn_array_vm_release(old, old->reserved);
+  }
+
+  return (block + 1);
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_vm_free(void *pointer)
+{
+  if (pointer)
+  {
+    dyn_array_vm_block *block = (dyn_array_vm_block *)pointer - 1;
+    dyn_array_vm_release(block, block->reserved);
+  }
+}
+
+#endif /* DYN_ARRAY_VIRTUAL_MEMORY */
+
+/* #############################################################################
+ * # MREMAP BACKEND (linux)
+ * #############################################################################
+ */
+#ifdef DYN_ARRAY_MREMAP
+
+#ifndef __linux__
+#error "DYN_ARRAY_MREMAP is only available on linux"
+#endif
+
+/* Blocks of at least this many bytes are served from mmap and grown with mremap */
+#ifndef DYN_ARRAY_MREMAP_THRESHOLD
+#define DYN_ARRAY_MREMAP_THRESHOLD ((dyn_array_usize)256 * 1024)
+#endif
+
+/* Heap used for blocks below the threshold */
+#if !defined(DYN_ARRAY_MREMAP_HEAP_REALLOC) && !defined(DYN_ARRAY_MREMAP_HEAP_FREE)
+#include <stdlib.h>
+#define DYN_ARRAY_MREMAP_HEAP_REALLOC(p, s) (realloc(p, s))
+#define DYN_ARRAY_MREMAP_HEAP_FREE(p) (free(p))
+#endif
+
+/* Stored in front of the pointer handed to dyn_array. "mapped" is 0 for heap blocks */
+typedef struct dyn_array_mremap_block
+{
+  dyn_array_usize mapped;
+  dyn_array_usize size;
+
+} dyn_array_mremap_block;
+
+/* realloc compatible. Small blocks live on the heap, large blocks are page aligned mappings which
+   are grown by remapping the page tables (mremap MREMAP_MAYMOVE) instead of copying the content. */
+DYN_ARRAY_API DYN_ARRAY_INLINE void *dyn_array_mremap_realloc(void *pointer, dyn_array_usize size)
+{
+  dyn_array_mremap_block *block = pointer ? (dyn_array_mremap_block *)pointer - 1 : (dyn_array_mremap_block *)DYN_ARRAY_NULL;
+  dyn_array_usize total = size + sizeof(dyn_array_mremap_block);
+
+  if (block && block->mapped)
+  {
+    if (total > block->mapped)
+    {
+      dyn_array_usize mapped = dyn_array_round_up(total, (dyn_array_usize)DYN_ARRAY_PAGE_SIZE);
+      void *b = mremap(block, block->mapped, mapped, DYN_ARRAY_MREMAP_MAYMOVE);
+
+      if (b == DYN_ARRAY_MAP_FAILED)
+      {
+        return DYN_ARRAY_NULL;
+      }
+
+      block = (dyn_array_mremap_block *)b;
+      block->mapped = mapped;
+    }
+
+    block->size = total;
+    return (block + 1);
+  }
+
+  if (total < DYN_ARRAY_MREMAP_THRESHOLD)
+  {
+    block = (dyn_array_mremap_block *)DYN_ARRAY_MREMAP_HEAP_REALLOC(block, total);
+
+    if (!block)
+    {
+      return DYN_ARRAY_NULL;
+    }
+
+    block->mapped = 0;
+    block->size = total;
+    return (block + 1);
+  }
+
+  /* First allocation above the threshold or a heap block crossing it: move into a mapping once */
+  {
+    dyn_array_usize mapped = dyn_array_round_up(total, (dyn_array_usize)DYN_ARRAY_PAGE_SIZE);
+    void *b = mmap(DYN_ARRAY_NULL, mapped, DYN_ARRAY_PROT_READ | DYN_ARRAY_PROT_WRITE, DYN_ARRAY_MAP_PRIVATE | DYN_ARRAY_MAP_ANONYMOUS, -1, 0);
+    dyn_array_mremap_block *heap = block;
+
+    if (b == DYN_ARRAY_MAP_FAILED)
+    {
+      return DYN_ARRAY_NULL;
+    }
+
+    block = (dyn_array_mremap_block *)b;
+    block->mapped = mapped;
+    block->size = total;
+
+    if (heap)
+    {
+      dyn_array_memory_copy(block + 1, heap + 1, (heap->size < total ? heap->size : total) - sizeof(dyn_array_mremap_block));
+      DYN_ARRAY_MREMAP_HEAP_FREE(heap);
+    }
+
+    return (block + 1);
+  }
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_mremap_free(void *pointer)
+{
+  if (pointer)
+  {
+    dyn_array_mremap_block *block = (dyn_array_mremap_block *)pointer - 1;
+
+    if (block->mapped)
+    {
+      munmap(block, block->mapped);
+    }
+    else
+    {
+      DYN_ARRAY_MREMAP_HEAP_FREE(block);
+    }
+  }
+}
+
+#endif /* DYN_ARRAY_MREMAP */
+
+/* #############################################################################
+ * # HEADER LAYOUT
+ * #############################################################################
+ */
+#if defined(DYN_ARRAY_ALIGNMENT) && ((DYN_ARRAY_ALIGNMENT) & ((DYN_ARRAY_ALIGNMENT) - 1))
+#error "DYN_ARRAY_ALIGNMENT has to be a power of two"
+#endif
+
+typedef struct dyn_array_header
+{
+  dyn_array_size capacity;
+  dyn_array_size length;
+#ifndef DYN_ARRAY_HEADER_COMPACT
+  void *data; /* NULL if the storage is owned by the array, the header itself for a caller provided buffer, otherwise a dyn_array_storage */
+#endif
+#ifdef DYN_ARRAY_ALIGNMENT
+  dyn_array_size offset; /* Bytes between the start of the allocation and the header */
+#elif defined(DYN_ARRAY_SIZE_T) && !defined(DYN_ARRAY_HEADER_COMPACT)
+  dyn_array_size padding; /* Keeps the header a multiple of two pointers so element 0 stays aligned like malloc */
+#endif
+
+} dyn_array_header;
+
+#ifndef DYN_ARRAY_HEADER_COMPACT
+/* Storage which is not owned by the array and not a plain caller provided buffer (e.g. a memory mapped file) */
+typedef struct dyn_array_storage
+{
+  /* Provides room for "capacity" elements and returns the (possibly moved) array, NULL if it fails. Without a
+     grow function the array moves into owned storage like a caller provided buffer */
+  void *(*grow)(void *type, dyn_array_usize type_size, dyn_array_size capacity);
+
+  /* Called by dyn_array_free to release the storage (e.g. unmap the file), may be NULL */
+  void (*release)(void *type, dyn_array_usize type_size);
+
+} dyn_array_storage;
+#endif
+
+#ifdef DYN_ARRAY_ALIGNMENT
+/* The header is padded to a multiple of the alignment and placed directly in front of element 0 */
+#define DYN_ARRAY_HEADER_SIZE dyn_array_round_up(sizeof(dyn_array_header), DYN_ARRAY_ALIGNMENT)
+#define DYN_ARRAY_ALLOCATION_OVERHEAD (DYN_ARRAY_HEADER_SIZE + DYN_ARRAY_ALIGNMENT - 1)
+#define dyn_array_header(t) ((dyn_array_header *)((char *)(t) - DYN_ARRAY_HEADER_SIZE))
+#else
+#define DYN_ARRAY_HEADER_SIZE sizeof(dyn_array_header)
+#define DYN_ARRAY_ALLOCATION_OVERHEAD DYN_ARRAY_HEADER_SIZE
+#define dyn_array_header(t) ((dyn_array_header *)(t) - 1)
+#endif
+#define dyn_array_capacity(t) ((t) ? dyn_array_header(t)->capacity : 0)
+#define dyn_array_length(t) ((t) ? dyn_array_header(t)->length : 0)
+
+DYN_ARRAY_API DYN_ARRAY_INLINE void *dyn_array_grow_site_function(void *type, dyn_array_usize type_size, dyn_array_size capacity, dyn_array_size add_length DYN_ARRAY_TRACE_SITE_PARAMETERS)
+{
+  void *b;
+#ifdef DYN_ARRAY_TRACE
+  dyn_array_usize array = (dyn_array_usize)type; /* taken before realloc releases it */
+  dyn_array_size requested = capacity;
+#endif
+
+  if (add_length > 0)
+  {
+    dyn_array_size growth = (dyn_array_size)(DYN_ARRAY_GROW_FACTOR_FUNCTION(capacity));
+
+    if (add_length > DYN_ARRAY_SIZE_MAX - capacity)
+    {
+      return DYN_ARRAY_NULL;
+    }
+
+    capacity += add_length;
+    capacity = growth > DYN_ARRAY_SIZE_MAX - capacity ? DYN_ARRAY_SIZE_MAX : capacity + growth;
+
+#ifdef DYN_ARRAY_GROW_MIN_BYTES
+    if ((dyn_array_usize)capacity * type_size < (dyn_array_usize)(DYN_ARRAY_GROW_MIN_BYTES))
+    {
+      capacity = (dyn_array_size)(((dyn_array_usize)(DYN_ARRAY_GROW_MIN_BYTES) + type_size - 1) / type_size);
+    }
+#endif
+
+#ifdef DYN_ARRAY_GROW_ROUND_FUNCTION
+    if ((dyn_array_usize)capacity <= (DYN_ARRAY_USIZE_MAX - DYN_ARRAY_ALLOCATION_OVERHEAD - DYN_ARRAY_PAGE_SIZE) / type_size)
+    {
+      dyn_array_usize rounded = (DYN_ARRAY_GROW_ROUND_FUNCTION(type_size * capacity + DYN_ARRAY_ALLOCATION_OVERHEAD) - DYN_ARRAY_ALLOCATION_OVERHEAD) / type_size;
+      capacity = rounded > DYN_ARRAY_SIZE_MAX ? DYN_ARRAY_SIZE_MAX : (dyn_array_size)rounded;
+    }
+#endif
+
+    DYN_ARRAY_STATS_ADD(grows, 1);
+  }
+
+  /* The byte size is computed in dyn_array_usize and must not wrap around */
+  if (type_size && (dyn_array_usize)capacity > (DYN_ARRAY_USIZE_MAX - DYN_ARRAY_ALLOCATION_OVERHEAD) / type_size)
+  {
+    return DYN_ARRAY_NULL;
+  }
+
+#ifndef DYN_ARRAY_HEADER_COMPACT
+  /* Storage not owned by the array is never passed to realloc: a caller provided buffer moves into owned storage
+     once, other storage grows through its grow function */
+  if (type && dyn_array_header(type)->data)
+  {
+    dyn_array_storage *storage = (dyn_array_storage *)dyn_array_header(type)->data;
+    dyn_array_size length = dyn_array_header(type)->length;
+
+    if (capacity <= dyn_array_header(type)->capacity)
+    {
+      return type;
+    }
+
+    if ((void *)storage != (void *)dyn_array_header(type) && storage->grow)
+    {
+      return storage->grow(type, type_size, capacity);
+    }
+
+    b = dyn_array_grow_site_function(DYN_ARRAY_NULL, type_size, capacity, 0 DYN_ARRAY_TRACE_SITE_ARGUMENTS);
+
+    if (b)
+    {
+      dyn_array_memory_copy(b, type, type_size * length);
+      dyn_array_header(b)->length = length;
+      DYN_ARRAY_STATS_ADD(bytes_copied, type_size * length);
+    }
+
+    return (b);
+  }
+#endif
+
+#ifdef DYN_ARRAY_ALIGNMENT
+  {
+    dyn_array_header *header = type ? dyn_array_header(type) : (dyn_array_header *)DYN_ARRAY_NULL;
+    dyn_array_usize offset = header ? header->offset : 0;
+    dyn_array_usize used = header ? DYN_ARRAY_HEADER_SIZE + type_size * (header->length < capacity ? header->length : capacity) : 0;
+    char *raw = (char *)DYN_ARRAY_FUNCTION_REALLOC(header ? (char *)header - offset : 0, type_size * capacity + DYN_ARRAY_ALLOCATION_OVERHEAD);
+
+    if (!raw)
+    {
+      return DYN_ARRAY_NULL;
+    }
+
+    b = raw + dyn_array_round_up((dyn_array_usize)raw + DYN_ARRAY_HEADER_SIZE, DYN_ARRAY_ALIGNMENT) - (dyn_array_usize)raw;
+
+    /* The allocator kept the content at the old offset which may not be aligned in the new block */
+    if (header && (char *)dyn_array_header(b) != raw + offset)
+    {
+      dyn_array_memory_move(dyn_array_header(b), raw + offset, used);
+    }
+
+    dyn_array_header(b)->offset = (dyn_array_size)((char *)dyn_array_header(b) - raw);
+  }
+#else
+  b = DYN_ARRAY_FUNCTION_REALLOC((type) ? dyn_array_header(type) : 0, type_size * capacity + DYN_ARRAY_HEADER_SIZE);
+
+  if (!b)
+  {
+    return DYN_ARRAY_NULL;
+  }
+
+  b = (char *)b + DYN_ARRAY_HEADER_SIZE;
+#endif
+
+  DYN_ARRAY_STATS_ADD(reallocs, 1);
+
+#ifdef DYN_ARRAY_COLLECT_STATISTICS
+  {
+    /* The header still holds the previous capacity. A moved block had its old content copied by realloc */
+    dyn_array_usize old_bytes = type ? type_size * dyn_array_header(b)->capacity + DYN_ARRAY_ALLOCATION_OVERHEAD : 0;
+    dyn_array_usize new_bytes = type_size * capacity + DYN_ARRAY_ALLOCATION_OVERHEAD;
+
+    dyn_array_stats_allocated(old_bytes, new_bytes);
+
+    if (type && b != type)
+    {
+      DYN_ARRAY_STATS_ADD(bytes_copied, old_bytes < new_bytes ? old_bytes : new_bytes);
+    }
+  }
+#endif
+
+  if (type == DYN_ARRAY_NULL)
+  {
+    dyn_array_header(b)->length = 0;
+#ifndef DYN_ARRAY_HEADER_COMPACT
+    dyn_array_header(b)->data = 0;
+#endif
+
+    DYN_ARRAY_STATS_ADD(inits, 1);
+  }
+
+#ifdef DYN_ARRAY_TRACE
+  dyn_array_trace_record(DYN_ARRAY_TRACE_GROW, site_file, site_line, type_size, array, (dyn_array_usize)b, dyn_array_header(b)->length, requested, add_length, array ? dyn_array_header(b)->capacity : 0, capacity);
+#endif
+
+  dyn_array_header(b)->capacity = capacity;
+
+  return (b);
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE void *dyn_array_grow_function(void *type, dyn_array_usize type_size, dyn_array_size capacity, dyn_array_size add_length)
+{
+  return dyn_array_grow_site_function(type, type_size, capacity, add_length DYN_ARRAY_TRACE_SITE_NONE);
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_free_site_function(dyn_array_header *type, dyn_array_usize type_size DYN_ARRAY_TRACE_SITE_PARAMETERS)
+{
+  (void)type_size; /* only needed for the statistics and the trace */
+
+#ifndef DYN_ARRAY_HEADER_COMPACT
+  /* A caller provided buffer stays with the caller, other storage is handed back through its release function */
+  if (type->data)
+  {
+    dyn_array_storage *storage = (dyn_array_storage *)type->data;
+
+    if ((void *)storage != (void *)type && storage->release)
+    {
+      storage->release((char *)type + DYN_ARRAY_HEADER_SIZE, type_size);
+    }
+
+    return;
+  }
+#endif
+
+#ifdef DYN_ARRAY_TRACE
+  dyn_array_trace_record(DYN_ARRAY_TRACE_FREE, site_file, site_line, type_size, (dyn_array_usize)type + DYN_ARRAY_HEADER_SIZE, 0, type->length, 0, 0, type->capacity, 0);
+#endif
+
+  DYN_ARRAY_STATS_ADD(frees, 1);
+  DYN_ARRAY_STATS(dyn_array_stats_freed(type_size * type->capacity + DYN_ARRAY_ALLOCATION_OVERHEAD, type_size * type->length, type_size * (type->capacity - type->length)));
+#ifdef DYN_ARRAY_ALIGNMENT
+  DYN_ARRAY_FUNCTION_FREE((char *)type - type->offset);
+#else
+  DYN_ARRAY_FUNCTION_FREE(type);
+#endif
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_free_function(dyn_array_header *type, dyn_array_usize type_size)
+{
+  dyn_array_free_site_function(type, type_size DYN_ARRAY_TRACE_SITE_NONE);
+}
+
+/* Reallocs to a smaller capacity (at least the length). If the allocator can not provide the smaller block the array stays untouched */
+DYN_ARRAY_API DYN_ARRAY_INLINE void *dyn_array_shrink_function(void *type, dyn_array_usize type_size, dyn_array_size capacity DYN_ARRAY_TRACE_SITE_PARAMETERS)
+{
+  void *b;
+
+  if (!type)
+  {
+    return type;
+  }
+
+  if (capacity < dyn_array_header(type)->length)
+  {
+    capacity = dyn_array_header(type)->length;
+  }
+
+  if (capacity >= dyn_array_header(type)->capacity)
+  {
+    return type;
+  }
+
+#ifndef DYN_ARRAY_HEADER_COMPACT
+  /* A caller provided buffer stays in use */
+  if (dyn_array_header(type)->data)
+  {
+    return type;
+  }
+#endif
+
+  b = dyn_array_grow_site_function(type, type_size, capacity, 0 DYN_ARRAY_TRACE_SITE_ARGUMENTS);
+
+  return b ? b : type;
+}
+
+#ifndef DYN_ARRAY_HEADER_COMPACT
+/* Places an empty array into "buffer" (header included) with the capacity that fits. The buffer is used until
+   the array outgrows it, then the content moves into storage from DYN_ARRAY_FUNCTION_REALLOC. The buffer is
+   never reallocated or freed. Returns NULL if not even the header fits */
+DYN_ARRAY_API DYN_ARRAY_INLINE void *dyn_array_init_buffer_function(void *buffer, dyn_array_usize type_size, dyn_array_usize bytes)
+{
+  char *raw = (char *)buffer;
+  char *b;
+  dyn_array_usize capacity;
+
+#ifdef DYN_ARRAY_ALIGNMENT
+  b = raw + (dyn_array_round_up((dyn_array_usize)raw + DYN_ARRAY_HEADER_SIZE, DYN_ARRAY_ALIGNMENT) - (dyn_array_usize)raw);
+#else
+  b = raw + DYN_ARRAY_HEADER_SIZE;
+#endif
+
+  if (!buffer || (dyn_array_usize)(b - raw) > bytes)
+  {
+    return DYN_ARRAY_NULL;
+  }
+
+  capacity = type_size ? (bytes - (dyn_array_usize)(b - raw)) / type_size : 0;
+
+  dyn_array_header(b)->capacity = capacity > DYN_ARRAY_SIZE_MAX ? DYN_ARRAY_SIZE_MAX : (dyn_array_size)capacity;
+  dyn_array_header(b)->length = 0;
+  dyn_array_header(b)->data = dyn_array_header(b);
+#ifdef DYN_ARRAY_ALIGNMENT
+  dyn_array_header(b)->offset = (dyn_array_size)((char *)dyn_array_header(b) - raw);
+#endif
+
+  return b;
+}
+
+/* Bytes (and dyn_array_usize words for declaring a buffer) needed for "n" elements of "T" plus the header */
+#define DYN_ARRAY_BUFFER_BYTES(T, n) (DYN_ARRAY_ALLOCATION_OVERHEAD + sizeof(T) * (n))
+#define DYN_ARRAY_BUFFER_WORDS(T, n) ((DYN_ARRAY_BUFFER_BYTES(T, n) + sizeof(dyn_array_usize) - 1) / sizeof(dyn_array_usize))
+#endif
+
+#ifdef DYN_ARRAY_AUTO_SHRINK
+
+#ifndef DYN_ARRAY_SHRINK_DIVISOR
+#define DYN_ARRAY_SHRINK_DIVISOR 4
+#endif
+
+#ifndef DYN_ARRAY_SHRINK_MIN_BYTES
+#define DYN_ARRAY_SHRINK_MIN_BYTES 4096
+#endif
+
+#if DYN_ARRAY_SHRINK_DIVISOR < 3
+#error "DYN_ARRAY_SHRINK_DIVISOR has to be at least 3 otherwise twice the length does not shrink the capacity"
+#endif
+
+DYN_ARRAY_API DYN_ARRAY_INLINE void *dyn_array_shrink_check_function(void *type, dyn_array_usize type_size DYN_ARRAY_TRACE_SITE_PARAMETERS)
+{
+  dyn_array_header *header;
+  dyn_array_usize capacity;
+  dyn_array_usize minimum = (dyn_array_usize)(DYN_ARRAY_SHRINK_MIN_BYTES) / (type_size ? type_size : 1);
+
+  if (!type)
+  {
+    return type;
+  }
+
+  header = dyn_array_header(type);
+
+  if ((dyn_array_usize)header->capacity <= minimum || header->length >= header->capacity / DYN_ARRAY_SHRINK_DIVISOR)
+  {
+    return type;
+  }
+
+  capacity = (dyn_array_usize)header->length * 2;
+
+  return dyn_array_shrink_function(type, type_size, (dyn_array_size)(capacity > minimum ? capacity : minimum) DYN_ARRAY_TRACE_SITE_ARGUMENTS);
+}
+
+#define dyn_array_shrink_check(t) ((t) = dyn_array_shrink_check_function((t), sizeof *(t) DYN_ARRAY_TRACE_SITE_HERE))
+#endif
+
+/* Sets the length. Grows with the grow factor if needed and zeroes the new elements if requested */
+DYN_ARRAY_API DYN_ARRAY_INLINE void *dyn_array_resize_function(void *type, dyn_array_usize type_size, dyn_array_size length, int zero DYN_ARRAY_TRACE_SITE_PARAMETERS)
+{
+  dyn_array_size old_length = type ? dyn_array_header(type)->length : 0;
+
+  if (!type || length > dyn_array_header(type)->capacity)
+  {
+    dyn_array_size capacity = type ? dyn_array_header(type)->capacity : 0;
+
+    type = dyn_array_grow_site_function(type, type_size, capacity, length - (old_length < capacity ? old_length : capacity) DYN_ARRAY_TRACE_SITE_ARGUMENTS);
+
+    if (!type)
+    {
+      return DYN_ARRAY_NULL;
+    }
+  }
+
+  if (zero && length > old_length)
+  {
+    dyn_array_memory_zero((char *)type + type_size * old_length, type_size * (length - old_length));
+  }
+
+  dyn_array_header(type)->length = length;
+
+#ifdef DYN_ARRAY_AUTO_SHRINK
+  if (length < old_length)
+  {
+    type = dyn_array_shrink_check_function(type, type_size DYN_ARRAY_TRACE_SITE_ARGUMENTS);
+  }
+#endif
+
+  return type;
+}
+
+/* Out of line grow path of dyn_array_grow_check. Keeps the realloc call and its setup out of the inlined hot loops */
+DYN_ARRAY_API DYN_ARRAY_NOINLINE void *dyn_array_grow_cold_function(void *type, dyn_array_usize type_size, dyn_array_size add_length DYN_ARRAY_TRACE_SITE_PARAMETERS)
+{
+  return dyn_array_grow_site_function(type, type_size, type ? dyn_array_header(type)->capacity : 0, add_length DYN_ARRAY_TRACE_SITE_ARGUMENTS);
+}
+
+/* Moves the element staged behind the last one to "index" and shifts the tail up by one. Elements larger than the
+   stack buffer rotate in several passes. An index beyond the length is ignored */
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_insert_function(void *type, dyn_array_usize type_size, dyn_array_size index)
+{
+  dyn_array_word staged[8];
+  char *position;
+  dyn_array_usize bytes;
+  dyn_array_usize rotated;
+  dyn_array_usize chunk;
+
+  if (!type || index > dyn_array_header(type)->length)
+  {
+    return;
+  }
+
+  position = (char *)type + type_size * index;
+  bytes = type_size * (dyn_array_header(type)->length - index + 1);
+
+  for (rotated = 0; rotated < type_size; rotated += chunk)
+  {
+    chunk = type_size - rotated < sizeof(staged) ? type_size - rotated : sizeof(staged);
+
+    dyn_array_memory_copy(staged, position + bytes - chunk, chunk);
+    dyn_array_memory_move(position + chunk, position, bytes - chunk);
+    dyn_array_memory_copy(position, staged, chunk);
+  }
+
+  dyn_array_header(type)->length++;
+}
+
+/* Inserts "count" elements of "array" at "index" with a single block move of the tail. An index beyond the length is ignored */
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_insert_array_function(void *type, dyn_array_usize type_size, dyn_array_size index, const void *array, dyn_array_size count)
+{
+  char *position;
+
+  if (!type || index > dyn_array_header(type)->length)
+  {
+    return;
+  }
+
+  position = (char *)type + type_size * index;
+
+  dyn_array_memory_move(position + type_size * count, position, type_size * (dyn_array_header(type)->length - index));
+  dyn_array_memory_copy(position, array, type_size * count);
+  dyn_array_header(type)->length += count;
+}
+
+/* Removes "count" elements at "index" with a single block move of the tail. A range beyond the length is ignored */
+DYN_ARRAY_API DYN_ARRAY_INLINE void *dyn_array_erase_function(void *type, dyn_array_usize type_size, dyn_array_size index, dyn_array_size count)
+{
+  dyn_array_header *header;
+  char *position;
+
+  if (!type || index > dyn_array_header(type)->length || count > dyn_array_header(type)->length - index)
+  {
+    return type;
+  }
+
+  header = dyn_array_header(type);
+  position = (char *)type + type_size * index;
+
+  dyn_array_memory_move(position, position + type_size * count, type_size * (header->length - index - count));
+  header->length -= count;
+
+#ifdef DYN_ARRAY_AUTO_SHRINK
+  type = dyn_array_shrink_check_function(type, type_size DYN_ARRAY_TRACE_SITE_NONE);
+#endif
+
+  return type;
+}
+
+/* Removes the element at "index" in O(1) by moving the last element into its place. An index beyond the length is ignored */
+DYN_ARRAY_API DYN_ARRAY_INLINE void *dyn_array_swap_remove_function(void *type, dyn_array_usize type_size, dyn_array_size index)
+{
+  dyn_array_header *header;
+
+  if (!type || index >= dyn_array_header(type)->length)
+  {
+    return type;
+  }
+
+  header = dyn_array_header(type);
+
+  if (index != --header->length)
+  {
+    dyn_array_memory_copy_element((char *)type + type_size * index, (char *)type + type_size * header->length, type_size);
+  }
+
+#ifdef DYN_ARRAY_AUTO_SHRINK
+  type = dyn_array_shrink_check_function(type, type_size DYN_ARRAY_TRACE_SITE_NONE);
+#endif
+
+  return type;
+}
+
+#define dyn_array_grow(t, c, n) ((t) = dyn_array_grow_site_function((t), sizeof *(t), (c), (n) DYN_ARRAY_TRACE_SITE_HERE))
+#define dyn_array_grow_check(t, n) (DYN_ARRAY_UNLIKELY(!(t) || dyn_array_header(t)->length + (n) > dyn_array_header(t)->capacity) ? ((t) = dyn_array_grow_cold_function((t), sizeof *(t), (dyn_array_size)(n) DYN_ARRAY_TRACE_SITE_HERE), 0) : 0)
 
 #define dyn_array_init(t, c) (dyn_array_grow(t, c, 0))
 #define dyn_array_add(t, v) (dyn_array_grow_check(t, 1), (t)[dyn_array_header(t)->length++] = (v))
-#define dyn_array_add_array(t, a, c)               \
-  do                                               \
-  {                                                \
-    unsigned int i;                                \
-    dyn_array_grow_check(t, c);                    \
-    for (i = 0; i < c; ++i)                        \
-    {                                              \
-      (t)[dyn_array_header(t)->length++] = (a)[i]; \
-    }                                              \
+/* Appends without the capacity check. Only valid if capacity was reserved before (dyn_array_reserve/dyn_array_init) */
+#define dyn_array_add_unchecked(t, v) ((t)[dyn_array_header(t)->length++] = (v))
+#define dyn_array_add_array(t, a, c)                                                                             \
+  do                                                                                                             \
+  {                                                                                                              \
+    (void)sizeof((t) == (a)); /* t and a have to point to the same element type */                               \
+    dyn_array_grow_check(t, c);                                                                                  \
+    dyn_array_memory_copy((t) + dyn_array_header(t)->length, (a), sizeof *(t) * (dyn_array_size)(c));               \
+    dyn_array_header(t)->length += (dyn_array_size)(c);                                                          \
+  } while (0)
+/* Positional insert/erase. An index beyond the length is ignored, macro arguments are evaluated more than once.
+   The value is stored in the spare slot behind the last element before the tail moves, so it may refer to an element */
+#define dyn_array_insert(t, i, v) \
+  (dyn_array_grow_check(t, 1), (t)[dyn_array_header(t)->length] = (v), dyn_array_insert_function((t), sizeof *(t), (dyn_array_size)(i)))
+#define dyn_array_insert_array(t, i, a, c)                                                                     \
+  do                                                                                                           \
+  {                                                                                                            \
+    (void)sizeof((t) == (a)); /* t and a have to point to the same element type */                             \
+    dyn_array_grow_check(t, c);                                                                                \
+    dyn_array_insert_array_function((t), sizeof *(t), (dyn_array_size)(i), (a), (dyn_array_size)(c));          \
+  } while (0)
+#define dyn_array_erase_range(t, i, n) ((t) = dyn_array_erase_function((t), sizeof *(t), (dyn_array_size)(i), (dyn_array_size)(n)))
+#define dyn_array_erase(t, i) dyn_array_erase_range(t, i, 1)
+/* O(1) unordered removal: the last element takes the place of the removed one */
+#define dyn_array_swap_remove(t, i) ((t) = dyn_array_swap_remove_function((t), sizeof *(t), (dyn_array_size)(i)))
+/* Zero copy append: producers write directly behind the last element and commit the amount written afterwards */
+#define dyn_array_add_uninitialized(t, n) (dyn_array_grow_check(t, n), (t) + dyn_array_header(t)->length)
+#define dyn_array_add_commit(t, n) (dyn_array_header(t)->length += (dyn_array_size)(n))
+#ifdef DYN_ARRAY_AUTO_SHRINK
+#define dyn_array_del(t) (dyn_array_header(t)->length > 0 ? (dyn_array_header(t)->length--, dyn_array_shrink_check(t), dyn_array_header(t)->length + 1) : 0)
+#else
+#define dyn_array_del(t) (dyn_array_header(t)->length > 0 ? dyn_array_header(t)->length-- : 0)
+#endif
+/* Grows like dyn_array_grow_check to at least length + n plus the growth factor so that a reserve per add stays amortized */
+#define dyn_array_reserve(t, n) ((!(t) || dyn_array_header(t)->length + (n) > dyn_array_header(t)->capacity) ? ((t) = dyn_array_grow_cold_function((t), sizeof *(t), dyn_array_length(t) + (dyn_array_size)(n) - dyn_array_capacity(t) DYN_ARRAY_TRACE_SITE_HERE), 0) : 0)
+#define dyn_array_resize(t, n) ((t) = dyn_array_resize_function((t), sizeof *(t), (dyn_array_size)(n), 0 DYN_ARRAY_TRACE_SITE_HERE))
+#define dyn_array_resize_zero(t, n) ((t) = dyn_array_resize_function((t), sizeof *(t), (dyn_array_size)(n), 1 DYN_ARRAY_TRACE_SITE_HERE))
+#define dyn_array_clear(t) ((void)((t) ? (dyn_array_header(t)->length = 0) : 0))
+#define dyn_array_shrink_to_fit(t) ((t) = dyn_array_shrink_function((t), sizeof *(t), 0 DYN_ARRAY_TRACE_SITE_HERE))
+#define dyn_array_last(t) ((t)[dyn_array_header(t)->length - 1])
+#define dyn_array_free(t) ((void)((t) ? dyn_array_free_site_function(dyn_array_header(t), sizeof *(t) DYN_ARRAY_TRACE_SITE_HERE) : (void)0), (t) = DYN_ARRAY_NULL)
+#ifndef DYN_ARRAY_HEADER_COMPACT
+#define dyn_array_init_buffer(t, buffer, bytes) ((t) = dyn_array_init_buffer_function((buffer), sizeof *(t), (dyn_array_usize)(bytes)))
+#define dyn_array_owns_storage(t) (!(t) || !dyn_array_header(t)->data)
+#endif
+
+/* #############################################################################
+ * # SORT
+ * #############################################################################
+ */
+/* Returns < 0, 0 or > 0 like the qsort comparator */
+typedef int (*dyn_array_compare_function)(const void *a, const void *b);
+
+/* Partitions below this amount of elements are finished with insertion sort */
+#ifndef DYN_ARRAY_SORT_INSERTION_THRESHOLD
+#define DYN_ARRAY_SORT_INSERTION_THRESHOLD 16
+#endif
+
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_sort_insertion(char *base, dyn_array_usize count, dyn_array_usize type_size, dyn_array_compare_function compare)
+{
+  dyn_array_usize i;
+  char *current;
+
+  for (i = 1; i < count; ++i)
+  {
+    for (current = base + i * type_size; current > base && compare(current - type_size, current) > 0; current -= type_size)
+    {
+      dyn_array_memory_swap(current - type_size, current, type_size);
+    }
+  }
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_sort_heap(char *base, dyn_array_usize count, dyn_array_usize type_size, dyn_array_compare_function compare)
+{
+  dyn_array_usize start = count / 2;
+  dyn_array_usize end = count;
+  dyn_array_usize root;
+  dyn_array_usize child;
+
+  while (end > 1)
+  {
+    if (start > 0)
+    {
+      --start; /* Build the heap */
+    }
+    else
+    {
+      --end; /* Move the maximum behind the heap */
+      dyn_array_memory_swap(base, base + end * type_size, type_size);
+    }
+
+    for (root = start; (child = 2 * root + 1) < end; root = child)
+    {
+      if (child + 1 < end && compare(base + child * type_size, base + (child + 1) * type_size) < 0)
+      {
+        ++child;
+      }
+
+      if (compare(base + root * type_size, base + child * type_size) >= 0)
+      {
+        break;
+      }
+
+      dyn_array_memory_swap(base + root * type_size, base + child * type_size, type_size);
+    }
+  }
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_sort_intro(char *base, dyn_array_usize count, dyn_array_usize type_size, dyn_array_compare_function compare, unsigned int depth)
+{
+  while (count > DYN_ARRAY_SORT_INSERTION_THRESHOLD)
+  {
+    char *middle = base + (count / 2) * type_size;
+    char *last = base + (count - 1) * type_size;
+    dyn_array_usize i = 0;
+    dyn_array_usize j = count;
+
+    if (depth-- == 0)
+    {
+      dyn_array_sort_heap(base, count, type_size, compare);
+      return;
+    }
+
+    /* Median of three. The maximum ends up last and stops the left scan, the pivot at base stops the right scan */
+    if (compare(middle, base) < 0)
+    {
+      dyn_array_memory_swap(middle, base, type_size);
+    }
+    if (compare(last, base) < 0)
+    {
+      dyn_array_memory_swap(last, base, type_size);
+    }
+    if (compare(last, middle) < 0)
+    {
+      dyn_array_memory_swap(last, middle, type_size);
+    }
+
+    dyn_array_memory_swap(base, middle, type_size);
+
+    /* Hoare partition around the pivot at base. Stopping on equal elements keeps duplicates balanced */
+    for (;;)
+    {
+      do
+      {
+        ++i;
+      } while (compare(base + i * type_size, base) < 0);
+
+      do
+      {
+        --j;
+      } while (compare(base, base + j * type_size) < 0);
+
+      if (i >= j)
+      {
+        break;
+      }
+
+      dyn_array_memory_swap(base + i * type_size, base + j * type_size, type_size);
+    }
+
+    dyn_array_memory_swap(base, base + j * type_size, type_size);
+
+    /* Recurse into the smaller side to bound the stack depth, loop on the larger one */
+    if (j < count - j - 1)
+    {
+      dyn_array_sort_intro(base, j, type_size, compare, depth);
+      base += (j + 1) * type_size;
+      count -= j + 1;
+    }
+    else
+    {
+      dyn_array_sort_intro(base + (j + 1) * type_size, count - j - 1, type_size, compare, depth);
+      count = j;
+    }
+  }
+
+  dyn_array_sort_insertion(base, count, type_size, compare);
+}
+
+/* In place introsort (quicksort, heapsort once the recursion gets too deep, insertion sort for small partitions) */
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_sort_function(void *type, dyn_array_usize type_size, dyn_array_size length, dyn_array_compare_function compare)
+{
+  unsigned int depth = 0;
+  dyn_array_size n;
+
+  for (n = length; n > 1; n >>= 1)
+  {
+    depth += 2;
+  }
+
+  if (type)
+  {
+    dyn_array_sort_intro((char *)type, length, type_size, compare, depth);
+  }
+}
+
+/* Key interpretations of the radix sort */
+#define DYN_ARRAY_KEY_UNSIGNED 0
+#define DYN_ARRAY_KEY_SIGNED 1
+#define DYN_ARRAY_KEY_FLOAT 2 /* IEEE 754 float or double */
+
+#define DYN_ARRAY_RADIX_MAX_KEY_SIZE 8
+
+/* Byte "significance" (0 = least significant) of a key as seen by the radix sort */
+DYN_ARRAY_API DYN_ARRAY_INLINE unsigned int dyn_array_radix_byte(const unsigned char *key, dyn_array_usize key_size, dyn_array_usize significance, int kind)
+{
+  static const unsigned short endian = 1;
+  int little_endian = *(const unsigned char *)&endian;
+  unsigned int byte = key[little_endian ? significance : key_size - 1 - significance];
+
+  if (kind == DYN_ARRAY_KEY_FLOAT && (key[little_endian ? key_size - 1 : 0] & 0x80))
+  {
+    /* Negative floats: all bits inverted so larger magnitudes sort first */
+    return ~byte & 0xFF;
+  }
+
+  if (kind != DYN_ARRAY_KEY_UNSIGNED && significance == key_size - 1)
+  {
+    /* Flip the sign bit so negative values sort before positive ones */
+    return byte ^ 0x80;
+  }
+
+  return byte;
+}
+
+/* Stable LSD radix sort on the key of "key_size" bytes at "key_offset" of every element.
+   Scatters between "type" and "scratch" (at least "length" elements) and returns the buffer holding the result.
+   Passes in which every element has the same key byte are skipped */
+DYN_ARRAY_API DYN_ARRAY_INLINE void *dyn_array_radix_sort_function(void *type, void *scratch, dyn_array_usize type_size, dyn_array_size length, dyn_array_usize key_offset, dyn_array_usize key_size, int kind)
+{
+  dyn_array_size counts[DYN_ARRAY_RADIX_MAX_KEY_SIZE][256];
+  unsigned char *source = (unsigned char *)type;
+  unsigned char *destination = (unsigned char *)scratch;
+  dyn_array_usize pass;
+  dyn_array_size i;
+
+  if (length < 2 || key_size == 0 || key_size > DYN_ARRAY_RADIX_MAX_KEY_SIZE)
+  {
+    return type;
+  }
+
+  dyn_array_memory_zero(counts, sizeof(counts));
+
+  /* One read pass builds the histograms of all key bytes */
+  for (i = 0; i < length; ++i)
+  {
+    const unsigned char *key = source + i * type_size + key_offset;
+
+    for (pass = 0; pass < key_size; ++pass)
+    {
+      counts[pass][dyn_array_radix_byte(key, key_size, pass, kind)]++;
+    }
+  }
+
+  for (pass = 0; pass < key_size; ++pass)
+  {
+    dyn_array_size *count = counts[pass];
+    dyn_array_size offset = 0;
+    unsigned int b;
+
+    if (count[dyn_array_radix_byte(source + key_offset, key_size, pass, kind)] == length)
+    {
+      continue;
+    }
+
+    for (b = 0; b < 256; ++b)
+    {
+      dyn_array_size c = count[b];
+      count[b] = offset;
+      offset += c;
+    }
+
+    for (i = 0; i < length; ++i)
+    {
+      const unsigned char *element = source + i * type_size;
+      unsigned char *target = destination + count[dyn_array_radix_byte(element + key_offset, key_size, pass, kind)]++ * type_size;
+
+      dyn_array_memory_copy_element(target, element, type_size);
+    }
+
+    /* Ping-pong */
+    {
+      unsigned char *swap = source;
+      source = destination;
+      destination = swap;
+    }
+  }
+
+  return source;
+}
+
+#define dyn_array_sort(t, compare) dyn_array_sort_function((t), sizeof *(t), dyn_array_length(t), (compare))
+
+/* Radix sorts t on a key of "key_size" bytes at byte "key_offset" inside every element. "s" is a scratch dyn_array of the
+   same type which is resized to the length of t and can be reused between calls. If the result ends up in the scratch
+   buffer t and s are exchanged (no copy back). Arrays which do not own their storage (caller buffer, mapped or persistent)
+   keep it: the result is copied back instead */
+#ifndef DYN_ARRAY_HEADER_COMPACT
+#define dyn_array_radix_exchangeable(t, s) (!dyn_array_header(t)->data && !dyn_array_header(s)->data)
+#else
+#define dyn_array_radix_exchangeable(t, s) 1
+#endif
+#define dyn_array_radix_sort_key(t, s, key_offset, key_size, kind)                                                                      \
+  do                                                                                                                                    \
+  {                                                                                                                                     \
+    (void)sizeof((t) == (s)); /* t and s have to point to the same element type */                                                      \
+    dyn_array_resize(s, dyn_array_length(t));                                                                                           \
+    if ((t) && (s) && dyn_array_radix_sort_function((t), (s), sizeof *(t), dyn_array_length(t), (key_offset), (key_size), (kind)) != (void *)(t)) \
+    {                                                                                                                                   \
+      if (dyn_array_radix_exchangeable(t, s))                                                                                           \
+      {                                                                                                                                 \
+        void *dyn_array_swap_ = (t);                                                                                                    \
+        (t) = (void *)(s);                                                                                                              \
+        (s) = dyn_array_swap_;                                                                                                          \
+      }                                                                                                                                 \
+      else                                                                                                                              \
+      {                                                                                                                                 \
+        dyn_array_memory_copy((t), (s), sizeof *(t) * dyn_array_header(t)->length);                                                     \
+      }                                                                                                                                 \
+    }                                                                                                                                   \
   } while (0)
-#define dyn_array_del(t) (dyn_array_header(t)->length > 0 ? dyn_array_header(t)->length-- : 0)
-#define dyn_array_last(t) ((t)[dyn_array_header(t)->length - 1])
-#define dyn_array_free(t) ((void)((t) ? dyn_array_free_function(dyn_array_header(t)) : (void)0), (t) = DYN_ARRAY_NULL)
+#define dyn_array_radix_sort(t, s, kind) dyn_array_radix_sort_key(t, s, 0, sizeof *(t), kind)
+
+/* #############################################################################
+ * # SORTED ARRAYS (search and set operations)
+ * #############################################################################
+ * All functions expect arrays sorted ascending by the same comparator.
+ */
+/* Index of the first element not less than "key" (length if there is none). Branchless: the loop runs
+   log2(length) times and the comparison result only selects the next base (conditional move) */
+DYN_ARRAY_API DYN_ARRAY_INLINE dyn_array_size dyn_array_lower_bound_function(const void *type, dyn_array_usize type_size, dyn_array_size length, const void *key, dyn_array_compare_function compare)
+{
+  const char *start = (const char *)type;
+  const char *base = start;
+  dyn_array_size n = length;
+
+  if (n == 0)
+  {
+    return 0;
+  }
+
+  while (n > 1)
+  {
+    dyn_array_size half = n / 2;
+    base = compare(base + half * type_size, key) < 0 ? base + half * type_size : base;
+    n -= half;
+  }
+
+  return (dyn_array_size)((dyn_array_usize)(base - start) / type_size) + (dyn_array_size)(compare(base, key) < 0);
+}
+
+/* Index of the first element greater than "key" (length if there is none) */
+DYN_ARRAY_API DYN_ARRAY_INLINE dyn_array_size dyn_array_upper_bound_function(const void *type, dyn_array_usize type_size, dyn_array_size length, const void *key, dyn_array_compare_function compare)
+{
+  const char *start = (const char *)type;
+  const char *base = start;
+  dyn_array_size n = length;
+
+  if (n == 0)
+  {
+    return 0;
+  }
+
+  while (n > 1)
+  {
+    dyn_array_size half = n / 2;
+    base = compare(base + half * type_size, key) <= 0 ? base + half * type_size : base;
+    n -= half;
+  }
+
+  return (dyn_array_size)((dyn_array_usize)(base - start) / type_size) + (dyn_array_size)(compare(base, key) <= 0);
+}
+
+/* Removes consecutive duplicates (keeps the first of every run) */
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_unique_function(void *type, dyn_array_usize type_size, dyn_array_compare_function compare)
+{
+  char *base = (char *)type;
+  dyn_array_size length;
+  dyn_array_size i;
+  dyn_array_size kept = 1;
+
+  if (!type || dyn_array_header(type)->length < 2)
+  {
+    return;
+  }
+
+  length = dyn_array_header(type)->length;
+
+  for (i = 1; i < length; ++i)
+  {
+    if (compare(base + (kept - 1) * type_size, base + i * type_size) != 0)
+    {
+      if (kept != i)
+      {
+        dyn_array_memory_copy_element(base + kept * type_size, base + i * type_size, type_size);
+      }
+      ++kept;
+    }
+  }
+
+  dyn_array_header(type)->length = kept;
+}
+
+/* Set operations with multiset semantics (like the C++ std::set_* algorithms) */
+#define DYN_ARRAY_SET_MERGE 0        /* All elements of a and b, stable (a first on equal elements) */
+#define DYN_ARRAY_SET_UNION 1        /* Elements of a and b, equal elements only once per pair */
+#define DYN_ARRAY_SET_INTERSECTION 2 /* Elements of a which have an equal element in b */
+#define DYN_ARRAY_SET_DIFFERENCE 3   /* Elements of a which have no equal element in b */
+
+/* Returns a new dyn_array with the result. The capacity is the maximum possible result size so the
+   output is written into a single allocation without any growth */
+DYN_ARRAY_API DYN_ARRAY_INLINE void *dyn_array_set_function(const void *a, const void *b, dyn_array_usize type_size, dyn_array_compare_function compare, int operation)
+{
+  const char *x = (const char *)a;
+  const char *y = (const char *)b;
+  dyn_array_size length_a = a ? dyn_array_header(a)->length : 0;
+  dyn_array_size length_b = b ? dyn_array_header(b)->length : 0;
+  dyn_array_size i = 0;
+  dyn_array_size j = 0;
+  dyn_array_size capacity;
+  dyn_array_size written = 0;
+  char *result;
+
+  if (operation == DYN_ARRAY_SET_INTERSECTION)
+  {
+    capacity = length_a < length_b ? length_a : length_b;
+  }
+  else if (operation == DYN_ARRAY_SET_DIFFERENCE)
+  {
+    capacity = length_a;
+  }
+  else
+  {
+    if (length_b > DYN_ARRAY_SIZE_MAX - length_a)
+    {
+      return DYN_ARRAY_NULL;
+    }
+    capacity = length_a + length_b;
+  }
+
+  result = (char *)dyn_array_grow_function(DYN_ARRAY_NULL, type_size, capacity, 0);
+
+  if (!result)
+  {
+    return DYN_ARRAY_NULL;
+  }
+
+  while (i < length_a && j < length_b)
+  {
+    int c = compare(x + i * type_size, y + j * type_size);
+
+    if (c < 0)
+    {
+      if (operation != DYN_ARRAY_SET_INTERSECTION)
+      {
+        dyn_array_memory_copy_element(result + written++ * type_size, x + i * type_size, type_size);
+      }
+      ++i;
+    }
+    else if (c > 0)
+    {
+      if (operation == DYN_ARRAY_SET_MERGE || operation == DYN_ARRAY_SET_UNION)
+      {
+        dyn_array_memory_copy_element(result + written++ * type_size, y + j * type_size, type_size);
+      }
+      ++j;
+    }
+    else
+    {
+      if (operation != DYN_ARRAY_SET_DIFFERENCE)
+      {
+        dyn_array_memory_copy_element(result + written++ * type_size, x + i * type_size, type_size);
+      }
+      ++i;
+
+      /* merge emits the equal element of b on the next round */
+      if (operation != DYN_ARRAY_SET_MERGE)
+      {
+        ++j;
+      }
+    }
+  }
+
+  /* Remaining tails are copied as one block */
+  if (operation != DYN_ARRAY_SET_INTERSECTION)
+  {
+    dyn_array_memory_copy(result + written * type_size, x + i * type_size, type_size * (length_a - i));
+    written += length_a - i;
+  }
+
+  if (operation == DYN_ARRAY_SET_MERGE || operation == DYN_ARRAY_SET_UNION)
+  {
+    dyn_array_memory_copy(result + written * type_size, y + j * type_size, type_size * (length_b - j));
+    written += length_b - j;
+  }
+
+  dyn_array_header(result)->length = written;
+
+  return result;
+}
+
+/* "key" is a pointer to a value of the element type */
+#define dyn_array_lower_bound(t, key, compare) dyn_array_lower_bound_function((t), sizeof *(t), dyn_array_length(t), (key), (compare))
+#define dyn_array_upper_bound(t, key, compare) dyn_array_upper_bound_function((t), sizeof *(t), dyn_array_length(t), (key), (compare))
+#define dyn_array_unique(t, compare) dyn_array_unique_function((t), sizeof *(t), (compare))
+
+/* r receives a NEW array (free the previous one first), a and b stay untouched */
+#define dyn_array_set_operation(r, a, b, compare, operation) \
+  ((void)sizeof((r) == (a)), (void)sizeof((a) == (b)), (r) = dyn_array_set_function((a), (b), sizeof *(a), (compare), (operation)))
+#define dyn_array_merge(r, a, b, compare) dyn_array_set_operation(r, a, b, compare, DYN_ARRAY_SET_MERGE)
+#define dyn_array_union(r, a, b, compare) dyn_array_set_operation(r, a, b, compare, DYN_ARRAY_SET_UNION)
+#define dyn_array_intersection(r, a, b, compare) dyn_array_set_operation(r, a, b, compare, DYN_ARRAY_SET_INTERSECTION)
+#define dyn_array_difference(r, a, b, compare) dyn_array_set_operation(r, a, b, compare, DYN_ARRAY_SET_DIFFERENCE)
+
+/* #############################################################################
+ * # NUMERIC KERNELS (float, double, int, dyn_array_i64)
+ * #############################################################################
+ * sum, min, max, argmin, argmax, dot, find (first equal), count (equal), fill and prefix_sum for numeric
+ * arrays, e.g. dyn_array_sum_float(t) or dyn_array_find_int(t, 42). The length is read from the header once.
+ * min/max/argmin/argmax expect a non empty array. find returns the length if no element is equal.
+ * Floating point sums and dot products use several partial sums, so the rounding differs from a plain loop.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+__extension__ typedef long long dyn_array_i64;
+#elif defined(_MSC_VER)
+typedef __int64 dyn_array_i64;
+#else
+typedef long dyn_array_i64; /* 64-bit on LP64 targets only */
+#endif
+
+/* Vector width in bytes: AVX2 32, SSE2/NEON 16. Uses GCC/clang vector extensions which lower to the instruction
+   set the translation unit is compiled for (-mavx2, default SSE2 on x86-64, NEON on arm64). Other compilers and
+   DYN_ARRAY_NO_SIMD use the scalar C89 kernels */
+#if !defined(DYN_ARRAY_NO_SIMD) && (defined(__GNUC__) || defined(__clang__))
+#if defined(__AVX2__)
+#define DYN_ARRAY_SIMD_BYTES 32
+#elif defined(__SSE2__) || defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define DYN_ARRAY_SIMD_BYTES 16
+#endif
+#endif
+
+#ifdef DYN_ARRAY_SIMD_BYTES
+
+typedef float dyn_array_v_float __attribute__((vector_size(DYN_ARRAY_SIMD_BYTES)));
+typedef double dyn_array_v_double __attribute__((vector_size(DYN_ARRAY_SIMD_BYTES)));
+typedef int dyn_array_v_int __attribute__((vector_size(DYN_ARRAY_SIMD_BYTES)));
+typedef unsigned int dyn_array_v_uint __attribute__((vector_size(DYN_ARRAY_SIMD_BYTES)));
+typedef dyn_array_i64 dyn_array_v_int64 __attribute__((vector_size(DYN_ARRAY_SIMD_BYTES)));
+typedef dyn_array_usize dyn_array_v_word __attribute__((vector_size(DYN_ARRAY_SIMD_BYTES)));
+
+/* Unaligned and aliasing views for loads and stores straight from the array */
+typedef dyn_array_v_float dyn_array_vu_float __attribute__((aligned(4), may_alias));
+typedef dyn_array_v_double dyn_array_vu_double __attribute__((aligned(8), may_alias));
+typedef dyn_array_v_int dyn_array_vu_int __attribute__((aligned(4), may_alias));
+typedef dyn_array_v_int64 dyn_array_vu_int64 __attribute__((aligned(8), may_alias));
+
+/* Non zero if any lane of a comparison mask is set */
+DYN_ARRAY_API DYN_ARRAY_INLINE int dyn_array_simd_any(dyn_array_v_word mask)
+{
+  dyn_array_usize any = 0;
+  unsigned int l;
+
+  for (l = 0; l < sizeof(dyn_array_v_word) / sizeof(dyn_array_usize); ++l)
+  {
+    any |= mask[l];
+  }
+
+  return any != 0;
+}
+
+/* T: element type, V: vector, VU: unaligned vector view, M: comparison mask vector (integer lanes of sizeof(T)) */
+#define DYN_ARRAY_NUMERIC_SIMD_DEFINE(name, T, V, VU, M)                                               \
+  DYN_ARRAY_API DYN_ARRAY_INLINE V dyn_array_splat_##name(T value)                                     \
+  {                                                                                                    \
+    V v;                                                                                               \
+    unsigned int l;                                                                                    \
+    for (l = 0; l < sizeof(V) / sizeof(T); ++l)                                                        \
+    {                                                                                                  \
+      v[l] = value;                                                                                    \
+    }                                                                                                  \
+    return v;                                                                                          \
+  }                                                                                                    \
+                                                                                                       \
+  /* Lane wise minimum (maximum) of a and b as a mask blend */                                         \
+  DYN_ARRAY_API DYN_ARRAY_INLINE V dyn_array_select_##name(V a, V b, int maximum)                      \
+  {                                                                                                    \
+    M take = maximum ? (M)(a > b) : (M)(a < b);                                                        \
+    return (V)(((M)a & take) | ((M)b & ~take));                                                        \
+  }                                                                                                    \
+                                                                                                       \
+  DYN_ARRAY_API DYN_ARRAY_INLINE T dyn_array_minmax_##name(const T *t, int maximum)                    \
+  {                                                                                                    \
+    const dyn_array_size w = (dyn_array_size)(sizeof(V) / sizeof(T));                                  \
+    dyn_array_size n = dyn_array_length(t);                                                            \
+    dyn_array_size i;                                                                                  \
+    unsigned int l;                                                                                    \
+    T m;                                                                                               \
+    V best;                                                                                            \
+    V other;                                                                                           \
+    if (n < w)                                                                                         \
+    {                                                                                                  \
+      for (m = n ? t[0] : 0, i = 1; i < n; ++i)                                                        \
+      {                                                                                                \
+        m = (maximum ? t[i] > m : t[i] < m) ? t[i] : m;                                                \
+      }                                                                                                \
+      return m;                                                                                        \
+    }                                                                                                  \
+    best = *(const VU *)t;                                                                             \
+    other = best;                                                                                      \
+    for (i = w; i + 2 * w <= n; i += 2 * w)                                                            \
+    {                                                                                                  \
+      best = dyn_array_select_##name(*(const VU *)(t + i), best, maximum);                             \
+      other = dyn_array_select_##name(*(const VU *)(t + i + w), other, maximum);                       \
+    }                                                                                                  \
+    best = dyn_array_select_##name(other, best, maximum);                                              \
+    /* The last vector overlaps the previous ones instead of a scalar tail (min/max are idempotent) */ \
+    best = dyn_array_select_##name(*(const VU *)(t + (i + w <= n ? i : n - w)), best, maximum);        \
+    best = dyn_array_select_##name(*(const VU *)(t + n - w), best, maximum);                           \
+    for (m = best[0], l = 1; l < w; ++l)                                                               \
+    {                                                                                                  \
+      m = (maximum ? best[l] > m : best[l] < m) ? best[l] : m;                                         \
+    }                                                                                                  \
+    return m;                                                                                          \
+  }                                                                                                    \
+                                                                                                       \
+  DYN_ARRAY_API DYN_ARRAY_INLINE dyn_array_size dyn_array_find_##name(const T *t, T value)             \
+  {                                                                                                    \
+    const dyn_array_size w = (dyn_array_size)(sizeof(V) / sizeof(T));                                  \
+    dyn_array_size n = dyn_array_length(t);                                                            \
+    dyn_array_size i = 0;                                                                              \
+    V v = dyn_array_splat_##name(value);                                                               \
+    for (; i + 4 * w <= n; i += 4 * w)                                                                 \
+    {                                                                                                  \
+      M e = (M)(*(const VU *)(t + i) == v) | (M)(*(const VU *)(t + i + w) == v) |                      \
+            (M)(*(const VU *)(t + i + 2 * w) == v) | (M)(*(const VU *)(t + i + 3 * w) == v);           \
+      if (dyn_array_simd_any((dyn_array_v_word)e))                                                     \
+      {                                                                                                \
+        break;                                                                                         \
+      }                                                                                                \
+    }                                                                                                  \
+    for (; i < n; ++i)                                                                                 \
+    {                                                                                                  \
+      if (t[i] == value)                                                                               \
+      {                                                                                                \
+        return i;                                                                                      \
+      }                                                                                                \
+    }                                                                                                  \
+    return n;                                                                                          \
+  }                                                                                                    \
+                                                                                                       \
+  DYN_ARRAY_API DYN_ARRAY_INLINE dyn_array_size dyn_array_count_##name(const T *t, T value)            \
+  {                                                                                                    \
+    const dyn_array_size w = (dyn_array_size)(sizeof(V) / sizeof(T));                                  \
+    dyn_array_size n = dyn_array_length(t);                                                            \
+    dyn_array_size i = 0;                                                                              \
+    dyn_array_size count = 0;                                                                          \
+    unsigned int l;                                                                                    \
+    V v = dyn_array_splat_##name(value);                                                               \
+    M lanes = (M)v ^ (M)v; /* zero */                                                                  \
+    for (; i + w <= n; i += w)                                                                         \
+    {                                                                                                  \
+      lanes -= (M)(*(const VU *)(t + i) == v); /* equal lanes are -1 */                                \
+    }                                                                                                  \
+    for (l = 0; l < w; ++l)                                                                            \
+    {                                                                                                  \
+      count += (dyn_array_size)lanes[l];                                                               \
+    }                                                                                                  \
+    for (; i < n; ++i)                                                                                 \
+    {                                                                                                  \
+      count += t[i] == value;                                                                          \
+    }                                                                                                  \
+    return count;                                                                                      \
+  }                                                                                                    \
+                                                                                                       \
+  DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_fill_##name(T *t, T value)                             \
+  {                                                                                                    \
+    const dyn_array_size w = (dyn_array_size)(sizeof(V) / sizeof(T));                                  \
+    dyn_array_size n = dyn_array_length(t);                                                            \
+    dyn_array_size i = 0;                                                                              \
+    V v = dyn_array_splat_##name(value);                                                               \
+    for (; i + w <= n; i += w)                                                                         \
+    {                                                                                                  \
+      *(VU *)(t + i) = v;                                                                              \
+    }                                                                                                  \
+    for (; i < n; ++i)                                                                                 \
+    {                                                                                                  \
+      t[i] = value;                                                                                    \
+    }                                                                                                  \
+  }
+
+/* Sum and dot product of element types whose sum fits the element type (four independent accumulators) */
+#define DYN_ARRAY_NUMERIC_SIMD_SUM_DEFINE(name, T, V, VU)                                                     \
+  DYN_ARRAY_API DYN_ARRAY_INLINE T dyn_array_sum_##name(const T *t)                                           \
+  {                                                                                                           \
+    const dyn_array_size w = (dyn_array_size)(sizeof(V) / sizeof(T));                                         \
+    dyn_array_size n = dyn_array_length(t);                                                                   \
+    dyn_array_size i = 0;                                                                                     \
+    unsigned int l;                                                                                           \
+    T sum = 0;                                                                                                \
+    V a0 = dyn_array_splat_##name(0);                                                                         \
+    V a1 = a0, a2 = a0, a3 = a0;                                                                              \
+    for (; i + 4 * w <= n; i += 4 * w)                                                                        \
+    {                                                                                                         \
+      a0 += *(const VU *)(t + i);                                                                             \
+      a1 += *(const VU *)(t + i + w);                                                                         \
+      a2 += *(const VU *)(t + i + 2 * w);                                                                     \
+      a3 += *(const VU *)(t + i + 3 * w);                                                                     \
+    }                                                                                                         \
+    a0 = (a0 + a1) + (a2 + a3);                                                                               \
+    for (; i + w <= n; i += w)                                                                                \
+    {                                                                                                         \
+      a0 += *(const VU *)(t + i);                                                                             \
+    }                                                                                                         \
+    for (l = 0; l < w; ++l)                                                                                   \
+    {                                                                                                         \
+      sum += a0[l];                                                                                           \
+    }                                                                                                         \
+    for (; i < n; ++i)                                                                                        \
+    {                                                                                                         \
+      sum += t[i];                                                                                            \
+    }                                                                                                         \
+    return sum;                                                                                               \
+  }                                                                                                           \
+                                                                                                              \
+  DYN_ARRAY_API DYN_ARRAY_INLINE T dyn_array_dot_##name(const T *a, const T *b)                               \
+  {                                                                                                           \
+    const dyn_array_size w = (dyn_array_size)(sizeof(V) / sizeof(T));                                         \
+    dyn_array_size n = dyn_array_length(a) < dyn_array_length(b) ? dyn_array_length(a) : dyn_array_length(b); \
+    dyn_array_size i = 0;                                                                                     \
+    unsigned int l;                                                                                           \
+    T sum = 0;                                                                                                \
+    V a0 = dyn_array_splat_##name(0);                                                                         \
+    V a1 = a0;                                                                                                \
+    for (; i + 2 * w <= n; i += 2 * w)                                                                        \
+    {                                                                                                         \
+      a0 += *(const VU *)(a + i) * *(const VU *)(b + i);                                                      \
+      a1 += *(const VU *)(a + i + w) * *(const VU *)(b + i + w);                                              \
+    }                                                                                                         \
+    a0 += a1;                                                                                                 \
+    for (l = 0; l < w; ++l)                                                                                   \
+    {                                                                                                         \
+      sum += a0[l];                                                                                           \
+    }                                                                                                         \
+    for (; i < n; ++i)                                                                                        \
+    {                                                                                                         \
+      sum += a[i] * b[i];                                                                                     \
+    }                                                                                                         \
+    return sum;                                                                                               \
+  }
+
+DYN_ARRAY_NUMERIC_SIMD_DEFINE(float, float, dyn_array_v_float, dyn_array_vu_float, dyn_array_v_int)
+DYN_ARRAY_NUMERIC_SIMD_DEFINE(double, double, dyn_array_v_double, dyn_array_vu_double, dyn_array_v_int64)
+DYN_ARRAY_NUMERIC_SIMD_DEFINE(int, int, dyn_array_v_int, dyn_array_vu_int, dyn_array_v_int)
+DYN_ARRAY_NUMERIC_SIMD_DEFINE(int64, dyn_array_i64, dyn_array_v_int64, dyn_array_vu_int64, dyn_array_v_int64)
+DYN_ARRAY_NUMERIC_SIMD_SUM_DEFINE(float, float, dyn_array_v_float, dyn_array_vu_float)
+DYN_ARRAY_NUMERIC_SIMD_SUM_DEFINE(double, double, dyn_array_v_double, dyn_array_vu_double)
+DYN_ARRAY_NUMERIC_SIMD_SUM_DEFINE(int64, dyn_array_i64, dyn_array_v_int64, dyn_array_vu_int64)
+
+/* int sums are returned as 64-bit. The lanes accumulate the unsigned low and the signed high 16 bits of every
+   element separately, which can not overflow within blocks of 65536 vectors, and are widened per block */
+DYN_ARRAY_API DYN_ARRAY_INLINE dyn_array_i64 dyn_array_sum_int(const int *t)
+{
+  const dyn_array_size w = (dyn_array_size)(sizeof(dyn_array_v_int) / sizeof(int));
+  dyn_array_size n = dyn_array_length(t);
+  dyn_array_size i = 0;
+  unsigned int l;
+  dyn_array_i64 sum = 0;
+  dyn_array_v_int shift = dyn_array_splat_int(16);
+  dyn_array_v_uint low_mask = (dyn_array_v_uint)dyn_array_splat_int(0xFFFF);
+
+  while (i + w <= n)
+  {
+    dyn_array_size end = n - i > 65536 * w ? i + 65536 * w : n;
+    dyn_array_v_uint low = low_mask & ~low_mask;
+    dyn_array_v_int high = shift - shift;
+
+    for (; i + w <= end; i += w)
+    {
+      dyn_array_v_int x = *(const dyn_array_vu_int *)(t + i);
+      low += (dyn_array_v_uint)x & low_mask;
+      high += x >> shift;
+    }
+
+    for (l = 0; l < w; ++l)
+    {
+      sum += (dyn_array_i64)high[l] * 65536 + (dyn_array_i64)low[l];
+    }
+  }
+
+  for (; i < n; ++i)
+  {
+    sum += t[i];
+  }
+
+  return sum;
+}
+
+#else
+
+#define DYN_ARRAY_NUMERIC_SCALAR_DEFINE(name, T)                                            \
+  DYN_ARRAY_API DYN_ARRAY_INLINE T dyn_array_minmax_##name(const T *t, int maximum)         \
+  {                                                                                         \
+    dyn_array_size n = dyn_array_length(t);                                                 \
+    dyn_array_size i;                                                                       \
+    T m = n ? t[0] : 0;                                                                     \
+    for (i = 1; i < n; ++i)                                                                 \
+    {                                                                                       \
+      m = (maximum ? t[i] > m : t[i] < m) ? t[i] : m;                                       \
+    }                                                                                       \
+    return m;                                                                               \
+  }                                                                                         \
+                                                                                            \
+  DYN_ARRAY_API DYN_ARRAY_INLINE dyn_array_size dyn_array_find_##name(const T *t, T value)  \
+  {                                                                                         \
+    dyn_array_size n = dyn_array_length(t);                                                 \
+    dyn_array_size i;                                                                       \
+    for (i = 0; i < n && t[i] != value; ++i)                                                \
+    {                                                                                       \
+    }                                                                                       \
+    return i;                                                                               \
+  }                                                                                         \
+                                                                                            \
+  DYN_ARRAY_API DYN_ARRAY_INLINE dyn_array_size dyn_array_count_##name(const T *t, T value) \
+  {                                                                                         \
+    dyn_array_size n = dyn_array_length(t);                                                 \
+    dyn_array_size i;                                                                       \
+    dyn_array_size count = 0;                                                               \
+    for (i = 0; i < n; ++i)                                                                 \
+    {                                                                                       \
+      count += t[i] == value;                                                               \
+    }                                                                                       \
+    return count;                                                                           \
+  }                                                                                         \
+                                                                                            \
+  DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_fill_##name(T *t, T value)                  \
+  {                                                                                         \
+    dyn_array_size n = dyn_array_length(t);                                                 \
+    dyn_array_size i;                                                                       \
+    for (i = 0; i < n; ++i)                                                                 \
+    {                                                                                       \
+      t[i] = value;                                                                         \
+    }                                                                                       \
+  }
+
+/* S: type of the sum */
+#define DYN_ARRAY_NUMERIC_SCALAR_SUM_DEFINE(name, T, S)             \
+  DYN_ARRAY_API DYN_ARRAY_INLINE S dyn_array_sum_##name(const T *t) \
+  {                                                                 \
+    dyn_array_size n = dyn_array_length(t);                         \
+    dyn_array_size i = 0;                                           \
+    S s0 = 0, s1 = 0, s2 = 0, s3 = 0;                               \
+    for (; i + 4 <= n; i += 4)                                      \
+    {                                                               \
+      s0 += t[i];                                                   \
+      s1 += t[i + 1];                                               \
+      s2 += t[i + 2];                                               \
+      s3 += t[i + 3];                                               \
+    }                                                               \
+    for (; i < n; ++i)                                              \
+    {                                                               \
+      s0 += t[i];                                                   \
+    }                                                               \
+    return (s0 + s1) + (s2 + s3);                                   \
+  }
+
+DYN_ARRAY_NUMERIC_SCALAR_DEFINE(float, float)
+DYN_ARRAY_NUMERIC_SCALAR_DEFINE(double, double)
+DYN_ARRAY_NUMERIC_SCALAR_DEFINE(int, int)
+DYN_ARRAY_NUMERIC_SCALAR_DEFINE(int64, dyn_array_i64)
+DYN_ARRAY_NUMERIC_SCALAR_SUM_DEFINE(float, float, float)
+DYN_ARRAY_NUMERIC_SCALAR_SUM_DEFINE(double, double, double)
+DYN_ARRAY_NUMERIC_SCALAR_SUM_DEFINE(int, int, dyn_array_i64)
+DYN_ARRAY_NUMERIC_SCALAR_SUM_DEFINE(int64, dyn_array_i64, dyn_array_i64)
+
+#endif /* DYN_ARRAY_SIMD_BYTES */
+
+/* Kernels without a vector version: the int dot product widens every product to 64-bit and the
+   prefix sum is a serial dependency chain */
+#define DYN_ARRAY_NUMERIC_COMMON_DEFINE(name, T)                                              \
+  DYN_ARRAY_API DYN_ARRAY_INLINE dyn_array_size dyn_array_arg_##name(const T *t, int maximum) \
+  {                                                                                           \
+    return dyn_array_find_##name(t, dyn_array_minmax_##name(t, maximum));                     \
+  }                                                                                           \
+                                                                                              \
+  /* Inclusive prefix sum in place: t[i] = t[0] + ... + t[i] */                               \
+  DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_prefix_sum_##name(T *t)                       \
+  {                                                                                           \
+    dyn_array_size n = dyn_array_length(t);                                                   \
+    dyn_array_size i;                                                                         \
+    for (i = 1; i < n; ++i)                                                                   \
+    {                                                                                         \
+      t[i] = (T)(t[i] + t[i - 1]);                                                            \
+    }                                                                                         \
+  }
+
+DYN_ARRAY_NUMERIC_COMMON_DEFINE(float, float)
+DYN_ARRAY_NUMERIC_COMMON_DEFINE(double, double)
+DYN_ARRAY_NUMERIC_COMMON_DEFINE(int, int)
+DYN_ARRAY_NUMERIC_COMMON_DEFINE(int64, dyn_array_i64)
+
+DYN_ARRAY_API DYN_ARRAY_INLINE dyn_array_i64 dyn_array_dot_int(const int *a, const int *b)
+{
+  dyn_array_size n = dyn_array_length(a) < dyn_array_length(b) ? dyn_array_length(a) : dyn_array_length(b);
+  dyn_array_size i = 0;
+  dyn_array_i64 s0 = 0, s1 = 0;
+
+  for (; i + 2 <= n; i += 2)
+  {
+    s0 += (dyn_array_i64)a[i] * b[i];
+    s1 += (dyn_array_i64)a[i + 1] * b[i + 1];
+  }
+
+  if (i < n)
+  {
+    s0 += (dyn_array_i64)a[i] * b[i];
+  }
+
+  return s0 + s1;
+}
+
+#ifndef DYN_ARRAY_SIMD_BYTES
+#define DYN_ARRAY_NUMERIC_SCALAR_DOT_DEFINE(name, T)                                                          \
+  DYN_ARRAY_API DYN_ARRAY_INLINE T dyn_array_dot_##name(const T *a, const T *b)                               \
+  {                                                                                                           \
+    dyn_array_size n = dyn_array_length(a) < dyn_array_length(b) ? dyn_array_length(a) : dyn_array_length(b); \
+    dyn_array_size i = 0;                                                                                     \
+    T s0 = 0, s1 = 0;                                                                                         \
+    for (; i + 2 <= n; i += 2)                                                                                \
+    {                                                                                                         \
+      s0 += a[i] * b[i];                                                                                      \
+      s1 += a[i + 1] * b[i + 1];                                                                              \
+    }                                                                                                         \
+    if (i < n)                                                                                                \
+    {                                                                                                         \
+      s0 += a[i] * b[i];                                                                                      \
+    }                                                                                                         \
+    return s0 + s1;                                                                                           \
+  }
+
+DYN_ARRAY_NUMERIC_SCALAR_DOT_DEFINE(float, float)
+DYN_ARRAY_NUMERIC_SCALAR_DOT_DEFINE(double, double)
+DYN_ARRAY_NUMERIC_SCALAR_DOT_DEFINE(int64, dyn_array_i64)
+#endif
+
+#define dyn_array_min_float(t) dyn_array_minmax_float((t), 0)
+#define dyn_array_max_float(t) dyn_array_minmax_float((t), 1)
+#define dyn_array_argmin_float(t) dyn_array_arg_float((t), 0)
+#define dyn_array_argmax_float(t) dyn_array_arg_float((t), 1)
+#define dyn_array_min_double(t) dyn_array_minmax_double((t), 0)
+#define dyn_array_max_double(t) dyn_array_minmax_double((t), 1)
+#define dyn_array_argmin_double(t) dyn_array_arg_double((t), 0)
+#define dyn_array_argmax_double(t) dyn_array_arg_double((t), 1)
+#define dyn_array_min_int(t) dyn_array_minmax_int((t), 0)
+#define dyn_array_max_int(t) dyn_array_minmax_int((t), 1)
+#define dyn_array_argmin_int(t) dyn_array_arg_int((t), 0)
+#define dyn_array_argmax_int(t) dyn_array_arg_int((t), 1)
+#define dyn_array_min_int64(t) dyn_array_minmax_int64((t), 0)
+#define dyn_array_max_int64(t) dyn_array_minmax_int64((t), 1)
+#define dyn_array_argmin_int64(t) dyn_array_arg_int64((t), 0)
+#define dyn_array_argmax_int64(t) dyn_array_arg_int64((t), 1)
+
+/* #############################################################################
+ * # FILTER AND PARTITION (stream compaction)
+ * #############################################################################
+ * Every element is copied to the current write position unconditionally and the write position only
+ * advances if the element is kept. Without a data dependent branch the cost does not depend on how
+ * unpredictable the selection is. The length is written once at the end.
+ */
+/* Returns non zero for elements matching the predicate. "context" is passed through */
+typedef int (*dyn_array_predicate_function)(const void *element, void *context);
+
+/* Keeps the elements for which the predicate result (0 or 1) equals "keep" */
+DYN_ARRAY_API DYN_ARRAY_INLINE void *dyn_array_filter_function(void *type, dyn_array_usize type_size, dyn_array_predicate_function predicate, void *context, int keep)
+{
+  char *base = (char *)type;
+  dyn_array_size length = dyn_array_length(type);
+  dyn_array_size written = 0;
+  dyn_array_size i;
+
+  for (i = 0; i < length; ++i)
+  {
+    const char *element = base + i * type_size;
+    dyn_array_memory_copy_element(base + written * type_size, element, type_size);
+    written += (dyn_array_size)((predicate(element, context) != 0) == keep);
+  }
+
+  if (!type)
+  {
+    return type;
+  }
+
+  dyn_array_header(type)->length = written;
+
+#ifdef DYN_ARRAY_AUTO_SHRINK
+  type = dyn_array_shrink_check_function(type, type_size DYN_ARRAY_TRACE_SITE_NONE);
+#endif
+
+  return type;
+}
+
+/* Keeps element i if byte i of "mask" is non zero (bits == 0) or bit i (LSB first) of "mask" is set (bits != 0) */
+DYN_ARRAY_API DYN_ARRAY_INLINE void *dyn_array_filter_mask_function(void *type, dyn_array_usize type_size, const unsigned char *mask, int bits)
+{
+  char *base = (char *)type;
+  dyn_array_size length = dyn_array_length(type);
+  dyn_array_size written = 0;
+  dyn_array_size i = 0;
+
+  if (bits)
+  {
+    /* Whole bytes of the bit mask without a kept element are skipped */
+    for (; i + 8 <= length; i += 8)
+    {
+      unsigned int byte = mask[i >> 3];
+      unsigned int b;
+
+      if (byte == 0)
+      {
+        continue;
+      }
+
+      for (b = 0; b < 8; ++b)
+      {
+        dyn_array_memory_copy_element(base + written * type_size, base + (i + b) * type_size, type_size);
+        written += (byte >> b) & 1;
+      }
+    }
+
+    for (; i < length; ++i)
+    {
+      dyn_array_memory_copy_element(base + written * type_size, base + i * type_size, type_size);
+      written += (dyn_array_size)((mask[i >> 3] >> (i & 7)) & 1);
+    }
+  }
+  else
+  {
+    for (; i < length; ++i)
+    {
+      dyn_array_memory_copy_element(base + written * type_size, base + i * type_size, type_size);
+      written += (dyn_array_size)(mask[i] != 0);
+    }
+  }
+
+  if (!type)
+  {
+    return type;
+  }
+
+  dyn_array_header(type)->length = written;
+
+#ifdef DYN_ARRAY_AUTO_SHRINK
+  type = dyn_array_shrink_check_function(type, type_size DYN_ARRAY_TRACE_SITE_NONE);
+#endif
+
+  return type;
+}
+
+/* Stable partition: moves the elements matching the predicate to the front keeping the relative order of both
+   groups. The others are collected in "scratch" (at least the length of type) and copied back as one block.
+   Returns the number of matching elements */
+DYN_ARRAY_API DYN_ARRAY_INLINE dyn_array_size dyn_array_partition_function(void *type, void *scratch, dyn_array_usize type_size, dyn_array_predicate_function predicate, void *context)
+{
+  char *base = (char *)type;
+  char *rest = (char *)scratch;
+  dyn_array_size length = dyn_array_length(type);
+  dyn_array_size matching = 0;
+  dyn_array_size others = 0;
+  dyn_array_size i;
+
+  if (!scratch)
+  {
+    return 0;
+  }
+
+  for (i = 0; i < length; ++i)
+  {
+    const char *element = base + i * type_size;
+    dyn_array_size match = (dyn_array_size)(predicate(element, context) != 0);
+
+    dyn_array_memory_copy_element(rest + others * type_size, element, type_size);
+    dyn_array_memory_copy_element(base + matching * type_size, element, type_size);
+    matching += match;
+    others += 1 - match;
+  }
+
+  dyn_array_memory_copy(base + matching * type_size, rest, type_size * others);
+
+  return matching;
+}
+
+#define dyn_array_filter(t, predicate, context) ((t) = dyn_array_filter_function((t), sizeof *(t), (predicate), (context), 1))
+#define dyn_array_remove_if(t, predicate, context) ((t) = dyn_array_filter_function((t), sizeof *(t), (predicate), (context), 0))
+#define dyn_array_filter_mask(t, mask) ((t) = dyn_array_filter_mask_function((t), sizeof *(t), (mask), 0))
+#define dyn_array_filter_bits(t, bits) ((t) = dyn_array_filter_mask_function((t), sizeof *(t), (bits), 1))
+
+/* "s" is a scratch dyn_array of the same type which is resized to the length of t and can be reused between calls */
+#define dyn_array_partition_stable(t, s, predicate, context) \
+  ((void)sizeof((t) == (s)), dyn_array_resize(s, dyn_array_length(t)), dyn_array_partition_function((t), (s), sizeof *(t), (predicate), (context)))
+
+/* #############################################################################
+ * # THREADS
+ * #############################################################################
+ */
+#if defined(DYN_ARRAY_PARALLEL) || defined(DYN_ARRAY_CONCURRENT)
+
+#if !defined(DYN_ARRAY_THREAD) && defined(_WIN32)
+/* Windows prototypes since include windows.h is immensily slow !!! */
+#ifndef DYN_ARRAY_WINAPI
+#if defined(_WIN64)
+#define DYN_ARRAY_WINAPI
+#else
+#define DYN_ARRAY_WINAPI __stdcall
+#endif
+#endif
+typedef struct dyn_array_win32_lock
+{
+  void *pointer; /* SRWLOCK and CONDITION_VARIABLE */
+
+} dyn_array_win32_lock;
+
+typedef struct dyn_array_win32_thread
+{
+  void *handle;
+  void *(*function)(void *);
+  void *argument;
+
+} dyn_array_win32_thread;
+
+void *DYN_ARRAY_WINAPI CreateThread(void *lpThreadAttributes, dyn_array_usize dwStackSize, unsigned long(DYN_ARRAY_WINAPI *lpStartAddress)(void *), void *lpParameter, unsigned long dwCreationFlags, unsigned long *lpThreadId);
+unsigned long DYN_ARRAY_WINAPI WaitForSingleObject(void *hHandle, unsigned long dwMilliseconds);
+int DYN_ARRAY_WINAPI CloseHandle(void *hObject);
+unsigned long DYN_ARRAY_WINAPI GetActiveProcessorCount(unsigned short GroupNumber);
+void DYN_ARRAY_WINAPI AcquireSRWLockExclusive(dyn_array_win32_lock *SRWLock);
+void DYN_ARRAY_WINAPI ReleaseSRWLockExclusive(dyn_array_win32_lock *SRWLock);
+int DYN_ARRAY_WINAPI SleepConditionVariableSRW(dyn_array_win32_lock *ConditionVariable, dyn_array_win32_lock *SRWLock, unsigned long dwMilliseconds, unsigned long Flags);
+void DYN_ARRAY_WINAPI WakeAllConditionVariable(dyn_array_win32_lock *ConditionVariable);
+
+DYN_ARRAY_API DYN_ARRAY_INLINE unsigned long DYN_ARRAY_WINAPI dyn_array_win32_thread_entry(void *argument)
+{
+  dyn_array_win32_thread *thread = (dyn_array_win32_thread *)argument;
+  thread->function(thread->argument);
+  return 0;
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE int dyn_array_win32_thread_create(dyn_array_win32_thread *thread, void *(*function)(void *), void *argument)
+{
+  thread->function = function;
+  thread->argument = argument;
+  thread->handle = CreateThread(DYN_ARRAY_NULL, 0, dyn_array_win32_thread_entry, thread, 0, DYN_ARRAY_NULL);
+  return thread->handle != DYN_ARRAY_NULL;
+}
+
+#define DYN_ARRAY_THREAD dyn_array_win32_thread
+#define DYN_ARRAY_THREAD_CREATE(t, f, a) (dyn_array_win32_thread_create(&(t), (f), (a)))
+#define DYN_ARRAY_THREAD_JOIN(t) ((void)WaitForSingleObject((t).handle, 0xFFFFFFFF), (void)CloseHandle((t).handle))
+#define DYN_ARRAY_MUTEX dyn_array_win32_lock
+#define DYN_ARRAY_MUTEX_INIT(m) ((m).pointer = DYN_ARRAY_NULL)
+#define DYN_ARRAY_MUTEX_DESTROY(m) ((void)(m))
+#define DYN_ARRAY_MUTEX_LOCK(m) (AcquireSRWLockExclusive(&(m)))
+#define DYN_ARRAY_MUTEX_UNLOCK(m) (ReleaseSRWLockExclusive(&(m)))
+#define DYN_ARRAY_CONDITION dyn_array_win32_lock
+#define DYN_ARRAY_CONDITION_INIT(c) ((c).pointer = DYN_ARRAY_NULL)
+#define DYN_ARRAY_CONDITION_DESTROY(c) ((void)(c))
+#define DYN_ARRAY_CONDITION_WAIT(c, m) ((void)SleepConditionVariableSRW(&(c), &(m), 0xFFFFFFFF, 0))
+#define DYN_ARRAY_CONDITION_BROADCAST(c) (WakeAllConditionVariable(&(c)))
+#ifndef DYN_ARRAY_CPU_COUNT
+#define DYN_ARRAY_CPU_COUNT() ((unsigned int)GetActiveProcessorCount(0xFFFF))
+#endif
+#elif !defined(DYN_ARRAY_THREAD)
+#include <pthread.h>
+#include <unistd.h>
+#define DYN_ARRAY_THREAD pthread_t
+#define DYN_ARRAY_THREAD_CREATE(t, f, a) (pthread_create(&(t), DYN_ARRAY_NULL, (f), (a)) == 0)
+#define DYN_ARRAY_THREAD_JOIN(t) ((void)pthread_join((t), DYN_ARRAY_NULL))
+#define DYN_ARRAY_MUTEX pthread_mutex_t
+#define DYN_ARRAY_MUTEX_INIT(m) ((void)pthread_mutex_init(&(m), DYN_ARRAY_NULL))
+#define DYN_ARRAY_MUTEX_DESTROY(m) ((void)pthread_mutex_destroy(&(m)))
+#define DYN_ARRAY_MUTEX_LOCK(m) ((void)pthread_mutex_lock(&(m)))
+#define DYN_ARRAY_MUTEX_UNLOCK(m) ((void)pthread_mutex_unlock(&(m)))
+#define DYN_ARRAY_CONDITION pthread_cond_t
+#define DYN_ARRAY_CONDITION_INIT(c) ((void)pthread_cond_init(&(c), DYN_ARRAY_NULL))
+#define DYN_ARRAY_CONDITION_DESTROY(c) ((void)pthread_cond_destroy(&(c)))
+#define DYN_ARRAY_CONDITION_WAIT(c, m) ((void)pthread_cond_wait(&(c), &(m)))
+#define DYN_ARRAY_CONDITION_BROADCAST(c) ((void)pthread_cond_broadcast(&(c)))
+#ifndef DYN_ARRAY_CPU_COUNT
+#define DYN_ARRAY_CPU_COUNT() ((unsigned int)sysconf(_SC_NPROCESSORS_ONLN))
+#endif
+#endif
+
+#ifndef DYN_ARRAY_CPU_COUNT
+#define DYN_ARRAY_CPU_COUNT() 1
+#endif
+
+#endif /* DYN_ARRAY_PARALLEL || DYN_ARRAY_CONCURRENT */
+
+/* #############################################################################
+ * # PARALLEL (worker pool, parallel for / reduce / transform)
+ * #############################################################################
+ */
+#ifdef DYN_ARRAY_PARALLEL
+
+/* Chunks handed out per thread and call when the grain size is chosen automatically */
+#ifndef DYN_ARRAY_PARALLEL_CHUNKS_PER_THREAD
+#define DYN_ARRAY_PARALLEL_CHUNKS_PER_THREAD 16
+#endif
+
+/* Smallest automatic chunk. Arrays up to this length run on the calling thread only */
+#ifndef DYN_ARRAY_PARALLEL_MIN_GRAIN
+#define DYN_ARRAY_PARALLEL_MIN_GRAIN 4096
+#endif
+
+/* Bytes of reduction state per worker. Larger results run on the calling thread only */
+#ifndef DYN_ARRAY_PARALLEL_PARTIAL_SIZE
+#define DYN_ARRAY_PARALLEL_PARTIAL_SIZE 64
+#endif
+
+#define DYN_ARRAY_PARALLEL_CACHE_LINE 64
+
+/* Processes the elements [begin, end) of "type" */
+typedef void (*dyn_array_range_function)(void *type, dyn_array_usize begin, dyn_array_usize end, void *context);
+
+/* Accumulates the elements [begin, end) of "type" into "partial" */
+typedef void (*dyn_array_reduce_function)(const void *type, dyn_array_usize begin, dyn_array_usize end, void *partial, void *context);
+
+/* Combines a worker's "partial" into "result". Has to be associative and commutative */
+typedef void (*dyn_array_combine_function)(void *result, const void *partial, void *context);
+
+/* Writes destination [begin, end) from source [begin, end) */
+typedef void (*dyn_array_transform_function)(void *destination, const void *source, dyn_array_usize begin, dyn_array_usize end, void *context);
+
+/* Current job, written under the pool mutex before the generation is advanced */
+typedef struct dyn_array_parallel_job
+{
+  void *destination;
+  const void *source;
+  dyn_array_usize length;
+  dyn_array_usize grain;
+  dyn_array_range_function range;
+  dyn_array_reduce_function reduce;
+  dyn_array_transform_function transform;
+  void *context;
+
+} dyn_array_parallel_job;
+
+struct dyn_array_parallel_pool;
+
+/* One per thread (the calling thread is worker 0), padded to a cache line so partials do not false share */
+typedef struct dyn_array_parallel_slot
+{
+  union
+  {
+    unsigned char bytes[DYN_ARRAY_PARALLEL_PARTIAL_SIZE];
+    double d;
+    dyn_array_usize u;
+    void *p;
+
+  } partial;
+
+  struct dyn_array_parallel_pool *pool;
+  DYN_ARRAY_THREAD thread;
+
+} dyn_array_parallel_slot;
+
+typedef struct dyn_array_parallel_pool
+{
+  DYN_ARRAY_MUTEX mutex;
+  DYN_ARRAY_CONDITION wake; /* workers wait for the next generation */
+  DYN_ARRAY_CONDITION done; /* the caller waits for "active" to drop to 0 */
+  unsigned int generation;
+  unsigned int active;
+  int stop;
+
+  unsigned int thread_count; /* including the calling thread */
+  dyn_array_usize slot_size;
+  unsigned char *slots; /* cache line aligned */
+  void *memory;
+
+  dyn_array_usize grain; /* elements per chunk, 0 (default) chooses automatically */
+  dyn_array_parallel_job job;
+
+  /* Next unclaimed element. Kept on its own cache line since every chunk claim writes it */
+  unsigned char padding_before[DYN_ARRAY_PARALLEL_CACHE_LINE];
+  volatile dyn_array_usize next;
+  unsigned char padding_after[DYN_ARRAY_PARALLEL_CACHE_LINE];
+
+} dyn_array_parallel_pool;
+
+#define dyn_array_parallel_slot_at(pool, i) ((dyn_array_parallel_slot *)((pool)->slots + (dyn_array_usize)(i) * (pool)->slot_size))
+
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_parallel_chunk(dyn_array_parallel_job *job, dyn_array_usize begin, dyn_array_usize end, void *partial)
+{
+  if (job->reduce)
+  {
+    job->reduce(job->source, begin, end, partial, job->context);
+  }
+  else if (job->transform)
+  {
+    job->transform(job->destination, job->source, begin, end, job->context);
+  }
+  else
+  {
+    job->range(job->destination, begin, end, job->context);
+  }
+}
+
+/* Claims chunks of the current job until the counter passes the end (dynamic chunking). Fast threads simply
+   claim more chunks so uneven per element costs are balanced without work stealing deques */
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_parallel_execute(dyn_array_parallel_pool *pool, dyn_array_parallel_slot *slot)
+{
+  dyn_array_usize length = pool->job.length;
+  dyn_array_usize grain = pool->job.grain;
+
+  for (;;)
+  {
+    dyn_array_usize begin = DYN_ARRAY_ATOMIC_FETCH_ADD(&pool->next, grain);
+
+    if (begin >= length)
+    {
+      break;
+    }
+
+    dyn_array_parallel_chunk(&pool->job, begin, length - begin > grain ? begin + grain : length, slot->partial.bytes);
+  }
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE void *dyn_array_parallel_worker(void *argument)
+{
+  dyn_array_parallel_slot *slot = (dyn_array_parallel_slot *)argument;
+  dyn_array_parallel_pool *pool = slot->pool;
+  unsigned int seen = 0;
+
+  DYN_ARRAY_MUTEX_LOCK(pool->mutex);
+
+  for (;;)
+  {
+    while (pool->generation == seen && !pool->stop)
+    {
+      DYN_ARRAY_CONDITION_WAIT(pool->wake, pool->mutex);
+    }
+
+    if (pool->stop)
+    {
+      break;
+    }
+
+    seen = pool->generation;
+    DYN_ARRAY_MUTEX_UNLOCK(pool->mutex);
+
+    dyn_array_parallel_execute(pool, slot);
+
+    DYN_ARRAY_MUTEX_LOCK(pool->mutex);
+
+    if (--pool->active == 0)
+    {
+      DYN_ARRAY_CONDITION_BROADCAST(pool->done);
+    }
+  }
+
+  DYN_ARRAY_MUTEX_UNLOCK(pool->mutex);
+
+  return DYN_ARRAY_NULL;
+}
+
+/* Creates a pool of "threads" threads including the calling thread (0 uses DYN_ARRAY_CPU_COUNT).
+   The workers are started once and sleep between jobs. Returns NULL if the allocation fails. If a
+   thread cannot be started the pool continues with the threads started so far */
+DYN_ARRAY_API DYN_ARRAY_INLINE dyn_array_parallel_pool *dyn_array_parallel_create(unsigned int threads)
+{
+  dyn_array_usize slot_size = dyn_array_round_up(sizeof(dyn_array_parallel_slot), DYN_ARRAY_PARALLEL_CACHE_LINE);
+  dyn_array_usize pool_size = dyn_array_round_up(sizeof(dyn_array_parallel_pool), DYN_ARRAY_PARALLEL_CACHE_LINE);
+  dyn_array_parallel_pool *pool;
+  unsigned char *memory;
+  unsigned int i;
+
+  if (threads == 0)
+  {
+    threads = DYN_ARRAY_CPU_COUNT();
+    threads = threads ? threads : 1;
+  }
+
+  memory = (unsigned char *)DYN_ARRAY_FUNCTION_REALLOC(DYN_ARRAY_NULL, DYN_ARRAY_PARALLEL_CACHE_LINE - 1 + pool_size + slot_size * threads);
+
+  if (!memory)
+  {
+    return DYN_ARRAY_NULL;
+  }
+
+  pool = (dyn_array_parallel_pool *)dyn_array_round_up((dyn_array_usize)memory, DYN_ARRAY_PARALLEL_CACHE_LINE);
+  dyn_array_memory_zero(pool, pool_size + slot_size * threads);
+  pool->memory = memory;
+  pool->slot_size = slot_size;
+  pool->slots = (unsigned char *)pool + pool_size;
+
+  DYN_ARRAY_MUTEX_INIT(pool->mutex);
+  DYN_ARRAY_CONDITION_INIT(pool->wake);
+  DYN_ARRAY_CONDITION_INIT(pool->done);
+
+  dyn_array_parallel_slot_at(pool, 0)->pool = pool;
+  pool->thread_count = 1;
+
+  for (i = 1; i < threads; ++i)
+  {
+    dyn_array_parallel_slot *slot = dyn_array_parallel_slot_at(pool, i);
+    slot->pool = pool;
+
+    if (!DYN_ARRAY_THREAD_CREATE(slot->thread, dyn_array_parallel_worker, slot))
+    {
+      break;
+    }
+
+    pool->thread_count++;
+  }
+
+  return pool;
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_parallel_destroy(dyn_array_parallel_pool *pool)
+{
+  unsigned int i;
+
+  if (!pool)
+  {
+    return;
+  }
+
+  DYN_ARRAY_MUTEX_LOCK(pool->mutex);
+  pool->stop = 1;
+  DYN_ARRAY_CONDITION_BROADCAST(pool->wake);
+  DYN_ARRAY_MUTEX_UNLOCK(pool->mutex);
+
+  for (i = 1; i < pool->thread_count; ++i)
+  {
+    DYN_ARRAY_THREAD_JOIN(dyn_array_parallel_slot_at(pool, i)->thread);
+  }
+
+  DYN_ARRAY_CONDITION_DESTROY(pool->done);
+  DYN_ARRAY_CONDITION_DESTROY(pool->wake);
+  DYN_ARRAY_MUTEX_DESTROY(pool->mutex);
+
+  DYN_ARRAY_FUNCTION_FREE(pool->memory);
+}
+
+/* Runs "job" on all threads of the pool and returns once every chunk is done. For reductions every worker
+   starts from a copy of "result" (the identity, e.g. 0 for a sum) and the partials are combined into "result"
+   in worker order. Short arrays, a NULL pool, a single thread or results larger than
+   DYN_ARRAY_PARALLEL_PARTIAL_SIZE run on the calling thread in one chunk. One job per pool at a time */
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_parallel_run(dyn_array_parallel_pool *pool, dyn_array_parallel_job *job, void *result, dyn_array_usize result_size, dyn_array_combine_function combine)
+{
+  dyn_array_usize threads = pool ? pool->thread_count : 1;
+  dyn_array_usize grain = pool ? pool->grain : 0;
+  unsigned int i;
+
+  if (grain == 0)
+  {
+    grain = job->length / (threads * DYN_ARRAY_PARALLEL_CHUNKS_PER_THREAD);
+    grain = grain < DYN_ARRAY_PARALLEL_MIN_GRAIN ? DYN_ARRAY_PARALLEL_MIN_GRAIN : grain;
+  }
+
+  if (threads == 1 || job->length <= grain || result_size > DYN_ARRAY_PARALLEL_PARTIAL_SIZE)
+  {
+    if (job->length)
+    {
+      dyn_array_parallel_chunk(job, 0, job->length, result);
+    }
+    return;
+  }
+
+  for (i = 0; job->reduce && i < pool->thread_count; ++i)
+  {
+    dyn_array_memory_copy(dyn_array_parallel_slot_at(pool, i)->partial.bytes, result, result_size);
+  }
+
+  DYN_ARRAY_MUTEX_LOCK(pool->mutex);
+  pool->job = *job;
+  pool->job.grain = grain;
+  pool->next = 0;
+  pool->active = pool->thread_count - 1;
+  pool->generation++;
+  DYN_ARRAY_CONDITION_BROADCAST(pool->wake);
+  DYN_ARRAY_MUTEX_UNLOCK(pool->mutex);
+
+  dyn_array_parallel_execute(pool, dyn_array_parallel_slot_at(pool, 0));
+
+  DYN_ARRAY_MUTEX_LOCK(pool->mutex);
+  while (pool->active)
+  {
+    DYN_ARRAY_CONDITION_WAIT(pool->done, pool->mutex);
+  }
+  DYN_ARRAY_MUTEX_UNLOCK(pool->mutex);
+
+  for (i = 0; job->reduce && i < pool->thread_count; ++i)
+  {
+    combine(result, dyn_array_parallel_slot_at(pool, i)->partial.bytes, job->context);
+  }
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_parallel_for_function(dyn_array_parallel_pool *pool, void *type, dyn_array_range_function function, void *context)
+{
+  dyn_array_parallel_job job;
+  dyn_array_memory_zero(&job, sizeof(job));
+  job.destination = type;
+  job.length = dyn_array_length(type);
+  job.range = function;
+  job.context = context;
+  dyn_array_parallel_run(pool, &job, DYN_ARRAY_NULL, 0, DYN_ARRAY_NULL);
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_parallel_reduce_function(dyn_array_parallel_pool *pool, const void *type, dyn_array_reduce_function reduce, dyn_array_combine_function combine, void *result, dyn_array_usize result_size, void *context)
+{
+  dyn_array_parallel_job job;
+  dyn_array_memory_zero(&job, sizeof(job));
+  job.source = type;
+  job.length = dyn_array_length(type);
+  job.reduce = reduce;
+  job.context = context;
+  dyn_array_parallel_run(pool, &job, result, result_size, combine);
+}
+
+/* Processes min(length(destination), length(source)) elements */
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_parallel_transform_function(dyn_array_parallel_pool *pool, void *destination, const void *source, dyn_array_transform_function transform, void *context)
+{
+  dyn_array_parallel_job job;
+  dyn_array_memory_zero(&job, sizeof(job));
+  job.destination = destination;
+  job.source = source;
+  job.length = dyn_array_length(destination) < dyn_array_length(source) ? dyn_array_length(destination) : dyn_array_length(source);
+  job.transform = transform;
+  job.context = context;
+  dyn_array_parallel_run(pool, &job, DYN_ARRAY_NULL, 0, DYN_ARRAY_NULL);
+}
+
+#define dyn_array_parallel_for(pool, t, function, context) (dyn_array_parallel_for_function((pool), (t), (function), (context)))
+#define dyn_array_parallel_reduce(pool, t, reduce, combine, result, context) (dyn_array_parallel_reduce_function((pool), (t), (reduce), (combine), (result), sizeof *(result), (context)))
+
+/* "d" is resized to the length of "s" first */
+#define dyn_array_parallel_transform(pool, d, s, transform, context) \
+  (dyn_array_resize(d, dyn_array_length(s)), dyn_array_parallel_transform_function((pool), (d), (s), (transform), (context)))
+
+#endif /* DYN_ARRAY_PARALLEL */
+
+/* #############################################################################
+ * # CONCURRENT APPEND (multi producer)
+ * #############################################################################
+ * Elements live in segments of geometrically growing size (FIRST, 2 * FIRST, 4 * FIRST ...) which are never
+ * moved, so growing does not need a lock and readers are never invalidated. Producers reserve slots with a
+ * single atomic add on "reserved", install missing segments with a compare and swap (the loser frees its
+ * allocation), write their elements and add their count to the "written" counter of the segment. No producer
+ * ever waits for another one. Readers may access [0, dyn_array_concurrent_length) at any time.
+ */
+#ifdef DYN_ARRAY_CONCURRENT
+
+/* Elements in the first segment, has to be a power of two */
+#ifndef DYN_ARRAY_CONCURRENT_FIRST
+#define DYN_ARRAY_CONCURRENT_FIRST 256
+#endif
+
+#if (DYN_ARRAY_CONCURRENT_FIRST) & ((DYN_ARRAY_CONCURRENT_FIRST) - 1)
+#error "DYN_ARRAY_CONCURRENT_FIRST has to be a power of two"
+#endif
+
+#define DYN_ARRAY_CONCURRENT_SEGMENTS (sizeof(dyn_array_usize) * 8)
+
+typedef struct dyn_array_concurrent
+{
+  void *volatile segments[DYN_ARRAY_CONCURRENT_SEGMENTS];
+  dyn_array_usize type_size;
+  volatile int failed; /* a segment allocation failed, elements were dropped */
+
+  /* Written by every producer so it gets its own cache line */
+  unsigned char padding_before[64];
+  volatile dyn_array_usize reserved;
+  unsigned char padding_after[64];
+
+  volatile dyn_array_usize written[DYN_ARRAY_CONCURRENT_SEGMENTS]; /* completed elements per segment */
+
+} dyn_array_concurrent;
+
+/* Segment k holds the indices [FIRST * (2^k - 1), FIRST * (2^(k + 1) - 1)) */
+#define dyn_array_concurrent_segment_of(i) (dyn_array_log2((i) / DYN_ARRAY_CONCURRENT_FIRST + 1))
+#define dyn_array_concurrent_segment_begin(k) (((dyn_array_usize)DYN_ARRAY_CONCURRENT_FIRST << (k)) - DYN_ARRAY_CONCURRENT_FIRST)
+
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_concurrent_init(dyn_array_concurrent *c, dyn_array_usize type_size)
+{
+  dyn_array_memory_zero(c, sizeof(*c));
+  c->type_size = type_size;
+}
+
+/* Not thread safe, all producers and readers have to be finished */
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_concurrent_free(dyn_array_concurrent *c)
+{
+  unsigned int k;
+
+  for (k = 0; k < DYN_ARRAY_CONCURRENT_SEGMENTS; ++k)
+  {
+    if (c->segments[k])
+    {
+      DYN_ARRAY_FUNCTION_FREE(c->segments[k]);
+    }
+  }
+
+  dyn_array_concurrent_init(c, c->type_size);
+}
+
+/* Returns segment k, allocating and installing it if it does not exist yet. NULL if the allocation failed */
+DYN_ARRAY_API DYN_ARRAY_NOINLINE void *dyn_array_concurrent_segment(dyn_array_concurrent *c, unsigned int k)
+{
+  void *segment = DYN_ARRAY_ATOMIC_LOAD(&c->segments[k]);
+
+  if (!segment)
+  {
+    segment = DYN_ARRAY_FUNCTION_REALLOC(DYN_ARRAY_NULL, ((dyn_array_usize)DYN_ARRAY_CONCURRENT_FIRST << k) * c->type_size);
+
+    if (segment && !DYN_ARRAY_ATOMIC_CAS_POINTER(&c->segments[k], DYN_ARRAY_NULL, segment))
+    {
+      DYN_ARRAY_FUNCTION_FREE(segment);
+      segment = DYN_ARRAY_ATOMIC_LOAD(&c->segments[k]);
+    }
+  }
+
+  return segment;
+}
+
+/* Address of element i. Only valid for i < dyn_array_concurrent_length (or slots reserved by the caller) */
+#define dyn_array_concurrent_at(c, i) \
+  ((void *)((char *)DYN_ARRAY_ATOMIC_LOAD(&(c)->segments[dyn_array_concurrent_segment_of(i)]) + ((i) - dyn_array_concurrent_segment_begin(dyn_array_concurrent_segment_of(i))) * (c)->type_size))
+
+/* Number of published elements: the leading segments whose reserved slots are all written. Once the
+   producers are done this is the number of added elements. "written" is loaded before "reserved" so every
+   completion counted belongs to a slot below the loaded "reserved" and equality means no slot is missing */
+DYN_ARRAY_API DYN_ARRAY_INLINE dyn_array_usize dyn_array_concurrent_length(dyn_array_concurrent *c)
+{
+  dyn_array_usize length = 0;
+  unsigned int k;
+
+  for (k = 0; k < DYN_ARRAY_CONCURRENT_SEGMENTS; ++k)
+  {
+    dyn_array_usize written = DYN_ARRAY_ATOMIC_LOAD(&c->written[k]);
+    dyn_array_usize reserved = DYN_ARRAY_ATOMIC_LOAD(&c->reserved);
+    dyn_array_usize begin = dyn_array_concurrent_segment_begin(k);
+    dyn_array_usize end = dyn_array_concurrent_segment_begin(k + 1);
+
+    if (reserved <= begin || written != (reserved < end ? reserved : end) - begin)
+    {
+      break;
+    }
+
+    length = begin + written;
+
+    if (reserved < end)
+    {
+      break;
+    }
+  }
+
+  return length;
+}
+
+/* Appends "count" elements from "elements" into consecutive slots. Thread safe and wait free apart from the
+   allocation of a new segment. Returns 0 if a segment could not be allocated ("failed" is set and the array
+   stops publishing at that segment) */
+DYN_ARRAY_API DYN_ARRAY_INLINE int dyn_array_concurrent_add_function(dyn_array_concurrent *c, const void *elements, dyn_array_usize count)
+{
+  dyn_array_usize index = DYN_ARRAY_ATOMIC_FETCH_ADD(&c->reserved, count);
+  dyn_array_usize i = index;
+  dyn_array_usize end = index + count;
+  const char *source = (const char *)elements;
+  int ok = 1;
+
+  while (i < end)
+  {
+    unsigned int k = dyn_array_concurrent_segment_of(i);
+    dyn_array_usize segment_end = dyn_array_concurrent_segment_begin(k + 1);
+    dyn_array_usize n = (end < segment_end ? end : segment_end) - i;
+    char *segment = (char *)DYN_ARRAY_ATOMIC_LOAD(&c->segments[k]);
+
+    if (DYN_ARRAY_UNLIKELY(!segment))
+    {
+      segment = (char *)dyn_array_concurrent_segment(c, k);
+    }
+
+    if (segment)
+    {
+      char *destination = segment + (i - dyn_array_concurrent_segment_begin(k)) * c->type_size;
+
+      if (n == 1)
+      {
+        dyn_array_memory_copy_element(destination, source, c->type_size);
+      }
+      else
+      {
+        dyn_array_memory_copy(destination, source, n * c->type_size);
+      }
+
+      (void)DYN_ARRAY_ATOMIC_FETCH_ADD(&c->written[k], n);
+    }
+    else
+    {
+      c->failed = 1;
+      ok = 0;
+    }
+
+    source += n * c->type_size;
+    i += n;
+  }
+
+  return ok;
+}
+
+/* Copies the elements [begin, begin + count) into "destination" */
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_concurrent_copy(dyn_array_concurrent *c, void *destination, dyn_array_usize begin, dyn_array_usize count)
+{
+  char *target = (char *)destination;
+  dyn_array_usize end = begin + count;
+
+  while (begin < end)
+  {
+    unsigned int k = dyn_array_concurrent_segment_of(begin);
+    dyn_array_usize segment_end = dyn_array_concurrent_segment_begin(k + 1);
+    dyn_array_usize n = (end < segment_end ? end : segment_end) - begin;
+
+    char *segment = (char *)DYN_ARRAY_ATOMIC_LOAD(&c->segments[k]);
+
+    if (segment)
+    {
+      dyn_array_memory_copy(target, segment + (begin - dyn_array_concurrent_segment_begin(k)) * c->type_size, n * c->type_size);
+    }
+
+    target += n * c->type_size;
+    begin += n;
+  }
+}
+
+#define dyn_array_concurrent_add(c, v) (dyn_array_concurrent_add_function((c), (v), 1))
+#define dyn_array_concurrent_add_array(c, a, n) (dyn_array_concurrent_add_function((c), (a), (dyn_array_usize)(n)))
+
+/* Copies the published elements into the dyn_array "t" (e.g. once all producers are done) */
+#define dyn_array_concurrent_to_array(c, t) \
+  (dyn_array_resize(t, dyn_array_concurrent_length(c)), dyn_array_concurrent_copy((c), (t), 0, dyn_array_length(t)))
+
+#endif /* DYN_ARRAY_CONCURRENT */
+
+/* #############################################################################
+ * # SEGMENTED ARRAY (stable element addresses)
+ * #############################################################################
+ * A segmented array "T **s" is a table of pointers to fixed size blocks with a small header in front of the
+ * table (like the dyn_array header in front of the data). Every block holds a power of two number of elements
+ * so element i is s[i >> shift][i & mask]. Growing allocates one more block and at most reallocs the table of
+ * block pointers: elements are never copied or moved and pointers to them stay valid until the array is freed.
+ */
+#ifndef DYN_ARRAY_SEGMENTED_BLOCK_BYTES
+#define DYN_ARRAY_SEGMENTED_BLOCK_BYTES 65536
+#endif
+
+typedef struct dyn_array_segmented_header
+{
+  dyn_array_usize length;
+  dyn_array_usize blocks;         /* allocated blocks */
+  dyn_array_usize table_capacity; /* block pointers which fit into the table */
+
+} dyn_array_segmented_header;
+
+/* Elements per block: the largest power of two fitting into DYN_ARRAY_SEGMENTED_BLOCK_BYTES (at least 1) */
+#define dyn_array_segmented_shift(s) (dyn_array_log2((DYN_ARRAY_SEGMENTED_BLOCK_BYTES / sizeof **(s)) | 1))
+#define dyn_array_segmented_block_size(s) ((dyn_array_usize)1 << dyn_array_segmented_shift(s))
+#define dyn_array_segmented_header(s) ((dyn_array_segmented_header *)(s) - 1)
+
+/* Makes room for at least "length" elements by allocating blocks (and growing the table of block pointers).
+   If an allocation fails the blocks allocated by this call are released again and the array keeps its
+   elements and capacity (NULL stays NULL), the callers detect it by the capacity */
+DYN_ARRAY_API DYN_ARRAY_NOINLINE void *dyn_array_segmented_grow_function(void *table, dyn_array_usize type_size, unsigned int shift, dyn_array_usize length)
+{
+  dyn_array_segmented_header *header = table ? dyn_array_segmented_header(table) : (dyn_array_segmented_header *)DYN_ARRAY_NULL;
+  dyn_array_usize blocks = (length + ((dyn_array_usize)1 << shift) - 1) >> shift;
+  dyn_array_usize block_bytes = type_size << shift;
+  dyn_array_usize old_blocks = header ? header->blocks : 0;
+
+  if (!header || blocks > header->table_capacity)
+  {
+    dyn_array_usize table_capacity = header ? header->table_capacity : 0;
+
+    table_capacity += table_capacity >> 1;
+    table_capacity = table_capacity < blocks ? blocks : table_capacity;
+    table_capacity = table_capacity < 4 ? 4 : table_capacity;
+
+    header = (dyn_array_segmented_header *)DYN_ARRAY_FUNCTION_REALLOC(header, sizeof(dyn_array_segmented_header) + table_capacity * sizeof(void *));
+
+    if (!header)
+    {
+      return table; /* a failed realloc leaves the old table in place */
+    }
+
+    if (!table)
+    {
+      header->length = 0;
+      header->blocks = 0;
+    }
+
+    header->table_capacity = table_capacity;
+  }
+
+  for (; header->blocks < blocks; ++header->blocks)
+  {
+    void *block = DYN_ARRAY_FUNCTION_REALLOC(DYN_ARRAY_NULL, block_bytes);
+
+    if (!block)
+    {
+      while (header->blocks > old_blocks)
+      {
+        DYN_ARRAY_FUNCTION_FREE(((void **)(header + 1))[--header->blocks]);
+      }
+
+      if (!table)
+      {
+        DYN_ARRAY_FUNCTION_FREE(header);
+        return DYN_ARRAY_NULL;
+      }
+
+      return (header + 1); /* the table may have moved but holds the same blocks */
+    }
+
+    ((void **)(header + 1))[header->blocks] = block;
+  }
+
+  return (header + 1);
+}
+
+/* Appends "count" elements block by block */
+DYN_ARRAY_API DYN_ARRAY_INLINE void *dyn_array_segmented_add_array_function(void *table, dyn_array_usize type_size, unsigned int shift, const void *elements, dyn_array_usize count)
+{
+  dyn_array_usize mask = ((dyn_array_usize)1 << shift) - 1;
+  const char *source = (const char *)elements;
+  dyn_array_usize length;
+
+  if (count == 0)
+  {
+    return table;
+  }
+
+  length = (table ? dyn_array_segmented_header(table)->length : 0) + count;
+  table = dyn_array_segmented_grow_function(table, type_size, shift, length);
+
+  if (!table || dyn_array_segmented_header(table)->blocks << shift < length)
+  {
+    return table;
+  }
+
+  length = dyn_array_segmented_header(table)->length;
+
+  while (count > 0)
+  {
+    dyn_array_usize offset = length & mask;
+    dyn_array_usize n = mask + 1 - offset < count ? mask + 1 - offset : count;
+
+    dyn_array_memory_copy((char *)((void **)table)[length >> shift] + offset * type_size, source, n * type_size);
+    source += n * type_size;
+    length += n;
+    count -= n;
+  }
+
+  dyn_array_segmented_header(table)->length = length;
+
+  return table;
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_segmented_free_function(void *table)
+{
+  dyn_array_segmented_header *header = dyn_array_segmented_header(table);
+  dyn_array_usize i;
+
+  for (i = 0; i < header->blocks; ++i)
+  {
+    DYN_ARRAY_FUNCTION_FREE(((void **)table)[i]);
+  }
+
+  DYN_ARRAY_FUNCTION_FREE(header);
+}
+
+#define dyn_array_segmented_length(s) ((s) ? dyn_array_segmented_header(s)->length : 0)
+#define dyn_array_segmented_capacity(s) ((s) ? dyn_array_segmented_header(s)->blocks << dyn_array_segmented_shift(s) : 0)
+#define dyn_array_segmented_at(s, i) ((s)[(dyn_array_usize)(i) >> dyn_array_segmented_shift(s)][(dyn_array_usize)(i) & (dyn_array_segmented_block_size(s) - 1)])
+#define dyn_array_segmented_last(s) (dyn_array_segmented_at(s, dyn_array_segmented_header(s)->length - 1))
+
+#define dyn_array_segmented_reserve(s, n) ((s) = dyn_array_segmented_grow_function((s), sizeof **(s), dyn_array_segmented_shift(s), dyn_array_segmented_length(s) + (dyn_array_usize)(n)))
+/* The element is dropped if allocating its block fails */
+#define dyn_array_segmented_add(s, v)                                                                                         \
+  ((void)(dyn_array_segmented_length(s) == dyn_array_segmented_capacity(s) ? (dyn_array_segmented_reserve(s, 1), 0) : 0), \
+   dyn_array_segmented_length(s) < dyn_array_segmented_capacity(s)                                                           \
+       ? (dyn_array_segmented_at(s, dyn_array_segmented_header(s)->length) = (v), (void)dyn_array_segmented_header(s)->length++) \
+       : (void)0)
+#define dyn_array_segmented_add_array(s, a, n) ((s) = dyn_array_segmented_add_array_function((s), sizeof **(s), dyn_array_segmented_shift(s), (a), (dyn_array_usize)(n)))
+#define dyn_array_segmented_del(s) (dyn_array_segmented_length(s) > 0 ? dyn_array_segmented_header(s)->length-- : 0)
+#define dyn_array_segmented_clear(s) ((void)((s) ? (dyn_array_segmented_header(s)->length = 0) : 0))
+#define dyn_array_segmented_free(s) ((void)((s) ? dyn_array_segmented_free_function(s) : (void)0), (s) = DYN_ARRAY_NULL)
+
+/* Chunk wise iteration: block b holds dyn_array_segmented_block_length(s, b) contiguous elements at s[b] */
+#define dyn_array_segmented_block_count(s) ((dyn_array_segmented_length(s) + dyn_array_segmented_block_size(s) - 1) >> dyn_array_segmented_shift(s))
+#define dyn_array_segmented_block_length(s, b) \
+  (dyn_array_segmented_length(s) - ((dyn_array_usize)(b) << dyn_array_segmented_shift(s)) < dyn_array_segmented_block_size(s) ? dyn_array_segmented_length(s) - ((dyn_array_usize)(b) << dyn_array_segmented_shift(s)) : dyn_array_segmented_block_size(s))
+
+/* #############################################################################
+ * # DEQUE (ring buffer)
+ * #############################################################################
+ * A deque "T *q" uses the same header in front of the data trick. The elements occupy the ring positions
+ * head, head + 1, ... (mod capacity). The capacity is a power of two so the wrap around is a mask. Growing
+ * allocates a new buffer and unwraps the content into it with at most two block copies.
+ */
+typedef struct dyn_array_deque_header
+{
+  dyn_array_size capacity;
+  dyn_array_size length;
+  dyn_array_size head;
+  dyn_array_size unused; /* keeps element 0 at the same alignment as for dyn_array */
+
+} dyn_array_deque_header;
+
+#define dyn_array_deque_header(q) ((dyn_array_deque_header *)(q) - 1)
+
+/* Makes room for at least "add_length" more elements. Returns NULL if the allocation fails */
+DYN_ARRAY_API DYN_ARRAY_NOINLINE void *dyn_array_deque_grow_function(void *type, dyn_array_usize type_size, dyn_array_size add_length)
+{
+  dyn_array_deque_header *header = type ? dyn_array_deque_header(type) : (dyn_array_deque_header *)DYN_ARRAY_NULL;
+  dyn_array_deque_header *b;
+  dyn_array_size length = header ? header->length : 0;
+  dyn_array_size capacity = header ? header->capacity : 4;
+
+  if (add_length > DYN_ARRAY_SIZE_MAX - length)
+  {
+    return DYN_ARRAY_NULL;
+  }
+
+  while (capacity < length + add_length)
+  {
+    if (capacity > DYN_ARRAY_SIZE_MAX / 2)
+    {
+      return DYN_ARRAY_NULL;
+    }
+    capacity *= 2;
+  }
+
+  if (header && capacity == header->capacity)
+  {
+    return type;
+  }
+
+  if (type_size && (dyn_array_usize)capacity > (DYN_ARRAY_USIZE_MAX - sizeof(dyn_array_deque_header)) / type_size)
+  {
+    return DYN_ARRAY_NULL;
+  }
+
+  b = (dyn_array_deque_header *)DYN_ARRAY_FUNCTION_REALLOC(DYN_ARRAY_NULL, sizeof(dyn_array_deque_header) + type_size * capacity);
+
+  if (!b)
+  {
+    return DYN_ARRAY_NULL;
+  }
+
+  DYN_ARRAY_STATS_ADD(reallocs, 1);
+  DYN_ARRAY_STATS(dyn_array_stats_allocated(header ? sizeof(dyn_array_deque_header) + type_size * header->capacity : 0, sizeof(dyn_array_deque_header) + type_size * capacity));
+
+  if (header)
+  {
+    dyn_array_size first = header->capacity - header->head < length ? header->capacity - header->head : length;
+
+    dyn_array_memory_copy(b + 1, (char *)type + (dyn_array_usize)header->head * type_size, (dyn_array_usize)first * type_size);
+    dyn_array_memory_copy((char *)(b + 1) + (dyn_array_usize)first * type_size, type, (dyn_array_usize)(length - first) * type_size);
+
+    DYN_ARRAY_STATS_ADD(bytes_copied, (dyn_array_usize)length * type_size);
+    DYN_ARRAY_STATS_ADD(grows, 1);
+    DYN_ARRAY_STATS_ADD(frees, 1);
+    DYN_ARRAY_FUNCTION_FREE(header);
+  }
+  else
+  {
+    DYN_ARRAY_STATS_ADD(inits, 1);
+  }
+
+  b->capacity = capacity;
+  b->length = length;
+  b->head = 0;
+  b->unused = 0;
+
+  return (b + 1);
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_deque_free_function(void *type, dyn_array_usize type_size)
+{
+  dyn_array_deque_header *header = dyn_array_deque_header(type);
+
+  (void)type_size; /* only needed for the statistics */
+
+  DYN_ARRAY_STATS_ADD(frees, 1);
+  DYN_ARRAY_STATS(dyn_array_stats_freed(sizeof(dyn_array_deque_header) + type_size * header->capacity, type_size * header->length, type_size * (header->capacity - header->length)));
+  DYN_ARRAY_FUNCTION_FREE(header);
+}
+
+#define dyn_array_deque_length(q) ((q) ? dyn_array_deque_header(q)->length : 0)
+#define dyn_array_deque_capacity(q) ((q) ? dyn_array_deque_header(q)->capacity : 0)
+#define dyn_array_deque_index(q, i) ((dyn_array_deque_header(q)->head + (dyn_array_size)(i)) & (dyn_array_deque_header(q)->capacity - 1))
+
+/* Element i counted from the front, front and back. Only valid for i < length */
+#define dyn_array_deque_at(q, i) ((q)[dyn_array_deque_index(q, i)])
+#define dyn_array_deque_front(q) ((q)[dyn_array_deque_header(q)->head])
+#define dyn_array_deque_back(q) ((q)[dyn_array_deque_index(q, dyn_array_deque_header(q)->length - 1)])
+
+#define dyn_array_deque_reserve(q, n) ((void)((!(q) || dyn_array_deque_header(q)->length + (n) > dyn_array_deque_header(q)->capacity) ? ((q) = dyn_array_deque_grow_function((q), sizeof *(q), (dyn_array_size)(n)), 0) : 0))
+#define dyn_array_deque_grow_check(q) \
+  ((void)(DYN_ARRAY_UNLIKELY(!(q) || dyn_array_deque_header(q)->length == dyn_array_deque_header(q)->capacity) ? ((q) = dyn_array_deque_grow_function((q), sizeof *(q), 1), 0) : 0))
+
+/* The value is stored into the free slot after the grow and before the head or the length change, so it may refer to an element */
+#define dyn_array_deque_push_back(q, v) \
+  (dyn_array_deque_grow_check(q), (q)[dyn_array_deque_index(q, dyn_array_deque_header(q)->length)] = (v), (void)dyn_array_deque_header(q)->length++)
+#define dyn_array_deque_push_front(q, v)                                                                                         \
+  (dyn_array_deque_grow_check(q), (q)[(dyn_array_deque_header(q)->head - 1) & (dyn_array_deque_header(q)->capacity - 1)] = (v), \
+   dyn_array_deque_header(q)->head = (dyn_array_deque_header(q)->head - 1) & (dyn_array_deque_header(q)->capacity - 1),          \
+   (void)dyn_array_deque_header(q)->length++)
+
+/* Remove and evaluate to the removed element. An empty deque stays empty and the result is a stale slot */
+#define dyn_array_deque_pop_back(q) \
+  ((void)(dyn_array_deque_header(q)->length > 0 ? dyn_array_deque_header(q)->length-- : 0), (q)[dyn_array_deque_index(q, dyn_array_deque_header(q)->length)])
+#define dyn_array_deque_pop_front(q)                                                                                                                                       \
+  ((void)(dyn_array_deque_header(q)->length > 0 ? (dyn_array_deque_header(q)->length--, dyn_array_deque_header(q)->head = (dyn_array_deque_header(q)->head + 1) & (dyn_array_deque_header(q)->capacity - 1)) : 0), \
+   (q)[(dyn_array_deque_header(q)->head - 1) & (dyn_array_deque_header(q)->capacity - 1)])
+
+/* The content as two contiguous spans: first span at q + head, the second one (possibly empty) at q */
+#define dyn_array_deque_first_span(q) ((q) ? (q) + dyn_array_deque_header(q)->head : (q))
+#define dyn_array_deque_first_span_length(q) \
+  ((q) ? (dyn_array_deque_header(q)->capacity - dyn_array_deque_header(q)->head < dyn_array_deque_header(q)->length ? dyn_array_deque_header(q)->capacity - dyn_array_deque_header(q)->head : dyn_array_deque_header(q)->length) : 0)
+#define dyn_array_deque_second_span_length(q) (dyn_array_deque_length(q) - dyn_array_deque_first_span_length(q))
+
+#define dyn_array_deque_clear(q) ((void)((q) ? (dyn_array_deque_header(q)->length = 0, dyn_array_deque_header(q)->head = 0) : 0))
+#define dyn_array_deque_free(q) ((void)((q) ? dyn_array_deque_free_function((q), sizeof *(q)) : (void)0), (q) = DYN_ARRAY_NULL)
+
+/* #############################################################################
+ * # STRUCT OF ARRAYS
+ * #############################################################################
+ * DYN_ARRAY_SOA_DEFINE generates a container with one column (a plain "type *") per field of an X-macro
+ * field list. All columns share the length/capacity of the container and live in one allocation, each
+ * column starting at a DYN_ARRAY_SOA_ALIGNMENT boundary so it can be handed to SIMD kernels directly.
+ *
+ *   #define POINT_FIELDS(X) X(int, x) X(int, y)
+ *   DYN_ARRAY_SOA_DEFINE(points, POINT_FIELDS)
+ *
+ * defines "typedef struct points { length; capacity; memory; int *x; int *y; } points" together with
+ * points_init, points_reserve, points_resize, points_add(&p, x, y), points_swap_remove and points_free.
+ * Field names must not be "length", "capacity", "memory" or "soa".
+ */
+#ifndef DYN_ARRAY_SOA_ALIGNMENT
+#define DYN_ARRAY_SOA_ALIGNMENT 64
+#endif
+
+#if (DYN_ARRAY_SOA_ALIGNMENT) & ((DYN_ARRAY_SOA_ALIGNMENT) - 1)
+#error "DYN_ARRAY_SOA_ALIGNMENT has to be a power of two"
+#endif
+
+#ifndef DYN_ARRAY_SOA_MIN_CAPACITY
+#define DYN_ARRAY_SOA_MIN_CAPACITY 16
+#endif
+
+/* Adds the bytes of one column with "capacity" elements to "*bytes". Returns 0 on overflow */
+DYN_ARRAY_API DYN_ARRAY_INLINE int dyn_array_soa_column_bytes(dyn_array_usize *bytes, dyn_array_usize capacity, dyn_array_usize type_size)
+{
+  dyn_array_usize column;
+
+  if (capacity > (DYN_ARRAY_USIZE_MAX - DYN_ARRAY_SOA_ALIGNMENT) / type_size)
+  {
+    return 0;
+  }
+
+  column = dyn_array_round_up(capacity * type_size, DYN_ARRAY_SOA_ALIGNMENT);
+
+  if (column > DYN_ARRAY_USIZE_MAX - *bytes)
+  {
+    return 0;
+  }
+
+  *bytes += column;
+
+  return 1;
+}
+
+/* Carves the next column out of a new allocation and copies the "length" elements of the old column into it */
+DYN_ARRAY_API DYN_ARRAY_INLINE void *dyn_array_soa_column_move(char **cursor, const void *old, dyn_array_usize length, dyn_array_usize capacity, dyn_array_usize type_size)
+{
+  void *column = *cursor;
+
+  if (length)
+  {
+    dyn_array_memory_copy(column, old, length * type_size);
+    DYN_ARRAY_STATS_ADD(bytes_copied, length * type_size);
+  }
+
+  *cursor += dyn_array_round_up(capacity * type_size, DYN_ARRAY_SOA_ALIGNMENT);
+
+  return column;
+}
+
+/* Doubles the capacity (starting at DYN_ARRAY_SOA_MIN_CAPACITY) until "length" rows fit */
+DYN_ARRAY_API DYN_ARRAY_INLINE dyn_array_size dyn_array_soa_next_capacity(dyn_array_size capacity, dyn_array_size length)
+{
+  capacity = capacity ? capacity : DYN_ARRAY_SOA_MIN_CAPACITY;
+
+  while (capacity < length)
+  {
+    if (capacity > DYN_ARRAY_SIZE_MAX / 2)
+    {
+      return length;
+    }
+    capacity *= 2;
+  }
+
+  return capacity;
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE char *dyn_array_soa_allocate(dyn_array_usize bytes)
+{
+  char *memory = (char *)DYN_ARRAY_FUNCTION_REALLOC(DYN_ARRAY_NULL, bytes);
+
+  if (memory)
+  {
+    DYN_ARRAY_STATS_ADD(reallocs, 1);
+  }
+
+  return memory;
+}
+
+/* Releases the previous allocation of a container which just moved into a new one */
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_soa_release(void *memory)
+{
+  if (memory)
+  {
+    DYN_ARRAY_STATS_ADD(grows, 1);
+    DYN_ARRAY_STATS_ADD(frees, 1);
+    DYN_ARRAY_FUNCTION_FREE(memory);
+  }
+  else
+  {
+    DYN_ARRAY_STATS_ADD(inits, 1);
+  }
+}
+
+/* Per field expansions of the X-macro field list */
+#define DYN_ARRAY_SOA_MEMBER(type, name) type *name;
+#define DYN_ARRAY_SOA_PARAMETER(type, name) , type name
+#define DYN_ARRAY_SOA_NULL(type, name) soa->name = (type *)DYN_ARRAY_NULL;
+#define DYN_ARRAY_SOA_BYTES(type, name) ok &= dyn_array_soa_column_bytes(&bytes, capacity, sizeof(type));
+#define DYN_ARRAY_SOA_ROW(type, name) +sizeof(type)
+#define DYN_ARRAY_SOA_MOVE(type, name) soa->name = (type *)dyn_array_soa_column_move(&cursor, soa->name, soa->length, capacity, sizeof(type));
+#define DYN_ARRAY_SOA_STORE(type, name) soa->name[soa->length] = name;
+#define DYN_ARRAY_SOA_SWAP(type, name) soa->name[index] = soa->name[soa->length];
+
+/* No semicolon after DYN_ARRAY_SOA_DEFINE(name, FIELDS) */
+#define DYN_ARRAY_SOA_DEFINE(name, FIELDS)                                                                                    \
+  typedef struct name                                                                                                          \
+  {                                                                                                                            \
+    dyn_array_size length;                                                                                                     \
+    dyn_array_size capacity;                                                                                                   \
+    void *memory;                                                                                                              \
+    FIELDS(DYN_ARRAY_SOA_MEMBER)                                                                                               \
+  } name;                                                                                                                      \
+                                                                                                                               \
+  DYN_ARRAY_API DYN_ARRAY_INLINE void name##_init(name *soa)                                                                   \
+  {                                                                                                                            \
+    soa->length = 0;                                                                                                           \
+    soa->capacity = 0;                                                                                                         \
+    soa->memory = DYN_ARRAY_NULL;                                                                                              \
+    FIELDS(DYN_ARRAY_SOA_NULL)                                                                                                 \
+  }                                                                                                                            \
+                                                                                                                               \
+  /* Bytes of the allocation holding "capacity" rows, 0 if they overflow */                                                    \
+  DYN_ARRAY_API DYN_ARRAY_INLINE dyn_array_usize name##_bytes(dyn_array_size capacity)                                         \
+  {                                                                                                                            \
+    dyn_array_usize bytes = DYN_ARRAY_SOA_ALIGNMENT - 1;                                                                       \
+    int ok = 1;                                                                                                                \
+                                                                                                                               \
+    FIELDS(DYN_ARRAY_SOA_BYTES)                                                                                                \
+    return ok ? bytes : 0;                                                                                                     \
+  }                                                                                                                            \
+                                                                                                                               \
+  /* Capacity for "add_length" more rows: a single allocation holding all columns. Returns 0 if it fails */                    \
+  DYN_ARRAY_API DYN_ARRAY_NOINLINE int name##_reserve(name *soa, dyn_array_size add_length)                                    \
+  {                                                                                                                            \
+    dyn_array_usize bytes;                                                                                                     \
+    dyn_array_size capacity;                                                                                                   \
+    char *memory;                                                                                                              \
+    char *cursor;                                                                                                              \
+                                                                                                                               \
+    if (add_length > DYN_ARRAY_SIZE_MAX - soa->length)                                                                         \
+    {                                                                                                                          \
+      return 0;                                                                                                                \
+    }                                                                                                                          \
+    if (soa->length + add_length <= soa->capacity)                                                                             \
+    {                                                                                                                          \
+      return 1;                                                                                                                \
+    }                                                                                                                          \
+                                                                                                                               \
+    capacity = dyn_array_soa_next_capacity(soa->capacity, soa->length + add_length);                                          \
+    bytes = name##_bytes(capacity);                                                                                            \
+                                                                                                                               \
+    if (!bytes || !(memory = dyn_array_soa_allocate(bytes)))                                                                   \
+    {                                                                                                                          \
+      return 0;                                                                                                                \
+    }                                                                                                                          \
+                                                                                                                               \
+    cursor = memory + (dyn_array_round_up((dyn_array_usize)memory, DYN_ARRAY_SOA_ALIGNMENT) - (dyn_array_usize)memory);        \
+    FIELDS(DYN_ARRAY_SOA_MOVE)                                                                                                 \
+    DYN_ARRAY_STATS(dyn_array_stats_allocated(soa->memory ? name##_bytes(soa->capacity) : 0, bytes));                          \
+    dyn_array_soa_release(soa->memory);                                                                                        \
+    soa->memory = memory;                                                                                                      \
+    soa->capacity = capacity;                                                                                                  \
+                                                                                                                               \
+    return 1;                                                                                                                  \
+  }                                                                                                                            \
+                                                                                                                               \
+  /* Sets the length, new rows are uninitialized. Returns 0 if the allocation fails */                                         \
+  DYN_ARRAY_API DYN_ARRAY_INLINE int name##_resize(name *soa, dyn_array_size length)                                           \
+  {                                                                                                                            \
+    if (length > soa->capacity && !name##_reserve(soa, length - soa->length))                                                  \
+    {                                                                                                                          \
+      return 0;                                                                                                                \
+    }                                                                                                                          \
+    soa->length = length;                                                                                                      \
+    return 1;                                                                                                                  \
+  }                                                                                                                            \
+                                                                                                                               \
+  /* Appends one row, one argument per field. Returns 0 if the allocation fails */                                             \
+  DYN_ARRAY_API DYN_ARRAY_INLINE int name##_add(name *soa FIELDS(DYN_ARRAY_SOA_PARAMETER))                                     \
+  {                                                                                                                            \
+    if (DYN_ARRAY_UNLIKELY(soa->length == soa->capacity) && !name##_reserve(soa, 1))                                           \
+    {                                                                                                                          \
+      return 0;                                                                                                                \
+    }                                                                                                                          \
+    FIELDS(DYN_ARRAY_SOA_STORE)                                                                                                \
+    soa->length++;                                                                                                             \
+    return 1;                                                                                                                  \
+  }                                                                                                                            \
+                                                                                                                               \
+  /* O(1) removal: the last row replaces row "index" in every column */                                                       \
+  DYN_ARRAY_API DYN_ARRAY_INLINE void name##_swap_remove(name *soa, dyn_array_size index)                                      \
+  {                                                                                                                            \
+    if (index >= soa->length)                                                                                                  \
+    {                                                                                                                          \
+      return; /* like dyn_array_swap_remove an index beyond the length is ignored */                                           \
+    }                                                                                                                          \
+    soa->length--;                                                                                                             \
+    FIELDS(DYN_ARRAY_SOA_SWAP)                                                                                                 \
+  }                                                                                                                            \
+                                                                                                                               \
+  DYN_ARRAY_API DYN_ARRAY_INLINE void name##_free(name *soa)                                                                   \
+  {                                                                                                                            \
+    if (soa->memory)                                                                                                           \
+    {                                                                                                                          \
+      DYN_ARRAY_STATS_ADD(frees, 1);                                                                                           \
+      DYN_ARRAY_STATS(dyn_array_stats_freed(name##_bytes(soa->capacity), (0 FIELDS(DYN_ARRAY_SOA_ROW)) * soa->length,          \
+                                            (0 FIELDS(DYN_ARRAY_SOA_ROW)) * (soa->capacity - soa->length)));                   \
+      DYN_ARRAY_FUNCTION_FREE(soa->memory);                                                                                    \
+    }                                                                                                                          \
+    name##_init(soa);                                                                                                          \
+  }
+
+/* #############################################################################
+ * # FILE FORMAT (save, load, map)
+ * #############################################################################
+ * A file holds a 64 byte dyn_array_file_header followed by zero padding and the raw elements at "data_offset"
+ * (a multiple of DYN_ARRAY_FILE_ALIGNMENT, so the elements of a mapped file are page aligned). The padding in
+ * front of the elements also has room for the in memory dyn_array header: dyn_array_map maps the file copy on
+ * write and writes the header right in front of element 0, so the elements are used in place and the file is
+ * never modified. Files are native: a different element size, version or byte order is rejected.
+ */
+#ifdef DYN_ARRAY_FILE
+
+#ifndef DYN_ARRAY_FILE_ALIGNMENT
+#define DYN_ARRAY_FILE_ALIGNMENT 4096
+#endif
+
+#if ((DYN_ARRAY_FILE_ALIGNMENT) & ((DYN_ARRAY_FILE_ALIGNMENT) - 1)) || (DYN_ARRAY_FILE_ALIGNMENT) < 256
+#error "DYN_ARRAY_FILE_ALIGNMENT has to be a power of two of at least 256"
+#endif
+
+#if defined(DYN_ARRAY_ALIGNMENT) && (DYN_ARRAY_ALIGNMENT) > (DYN_ARRAY_FILE_ALIGNMENT)
+#error "DYN_ARRAY_FILE_ALIGNMENT has to be at least DYN_ARRAY_ALIGNMENT"
+#endif
+
+#define DYN_ARRAY_FILE_MAGIC "DYNARRAY"
+#define DYN_ARRAY_FILE_VERSION 1u
+#define DYN_ARRAY_FILE_ENDIAN 0x01020304u
+
+typedef struct dyn_array_file_header
+{
+  char magic[8]; /* "DYNARRAY", not terminated */
+  unsigned int version;
+  unsigned int endian; /* DYN_ARRAY_FILE_ENDIAN in the byte order of the writer */
+  dyn_array_u64 type_size;
+  dyn_array_u64 length;
+  dyn_array_u64 alignment; /* of the element data within the file */
+  dyn_array_u64 data_offset;
+  dyn_array_u64 reserved[2];
+
+} dyn_array_file_header;
+
+/* Bytes per read/write call, below the 2GB limits of the OS calls */
+#define DYN_ARRAY_FILE_CHUNK ((dyn_array_usize)1 << 30)
+
+/* dyn_array_file_open modes: read only, write (created or truncated), read and write (created if missing) */
+#define DYN_ARRAY_FILE_READ 0
+#define DYN_ARRAY_FILE_WRITE 1
+#define DYN_ARRAY_FILE_UPDATE 2
+
+#ifdef _WIN32
+typedef void *dyn_array_file_handle;
+#define DYN_ARRAY_FILE_INVALID DYN_ARRAY_INVALID_HANDLE_VALUE
+
+DYN_ARRAY_API DYN_ARRAY_INLINE dyn_array_file_handle dyn_array_file_open(const char *path, int mode)
+{
+  unsigned long access = mode == DYN_ARRAY_FILE_READ ? DYN_ARRAY_GENERIC_READ : mode == DYN_ARRAY_FILE_WRITE ? DYN_ARRAY_GENERIC_WRITE : DYN_ARRAY_GENERIC_READ | DYN_ARRAY_GENERIC_WRITE;
+  unsigned long disposition = mode == DYN_ARRAY_FILE_READ ? DYN_ARRAY_OPEN_EXISTING : mode == DYN_ARRAY_FILE_WRITE ? DYN_ARRAY_CREATE_ALWAYS : DYN_ARRAY_OPEN_ALWAYS;
+
+  return CreateFileA(path, access, DYN_ARRAY_FILE_SHARE_READ, DYN_ARRAY_NULL, disposition, DYN_ARRAY_FILE_ATTRIBUTE_NORMAL, DYN_ARRAY_NULL);
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_file_close(dyn_array_file_handle file)
+{
+  CloseHandle(file);
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE int dyn_array_file_read(dyn_array_file_handle file, void *buffer, dyn_array_usize bytes)
+{
+  char *b = (char *)buffer;
+
+  while (bytes)
+  {
+    unsigned long chunk = (unsigned long)(bytes < DYN_ARRAY_FILE_CHUNK ? bytes : DYN_ARRAY_FILE_CHUNK);
+    unsigned long done = 0;
+
+    if (!ReadFile(file, b, chunk, &done, DYN_ARRAY_NULL) || done != chunk)
+    {
+      return 0;
+    }
+
+    b += chunk;
+    bytes -= chunk;
+  }
+
+  return 1;
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE int dyn_array_file_write(dyn_array_file_handle file, const void *buffer, dyn_array_usize bytes)
+{
+  const char *b = (const char *)buffer;
+
+  while (bytes)
+  {
+    unsigned long chunk = (unsigned long)(bytes < DYN_ARRAY_FILE_CHUNK ? bytes : DYN_ARRAY_FILE_CHUNK);
+    unsigned long done = 0;
+
+    if (!WriteFile(file, b, chunk, &done, DYN_ARRAY_NULL) || done != chunk)
+    {
+      return 0;
+    }
+
+    b += chunk;
+    bytes -= chunk;
+  }
+
+  return 1;
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE int dyn_array_file_seek(dyn_array_file_handle file, dyn_array_u64 offset)
+{
+  long high = (long)(offset >> 32);
+  return SetFilePointer(file, (long)(offset & 0xFFFFFFFFUL), &high, DYN_ARRAY_FILE_BEGIN) != DYN_ARRAY_INVALID_SET_FILE_POINTER;
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE dyn_array_u64 dyn_array_file_size(dyn_array_file_handle file)
+{
+  unsigned long high = 0;
+  unsigned long low = GetFileSize(file, &high);
+  return ((dyn_array_u64)high << 32) | low;
+}
+
+/* Private (copy on write) view of the first "bytes" of the file */
+DYN_ARRAY_API DYN_ARRAY_INLINE void *dyn_array_file_map_view(dyn_array_file_handle file, dyn_array_usize bytes)
+{
+  void *view;
+  void *mapping = CreateFileMappingA(file, DYN_ARRAY_NULL, DYN_ARRAY_PAGE_WRITECOPY, 0, 0, DYN_ARRAY_NULL);
+
+  if (!mapping)
+  {
+    return DYN_ARRAY_NULL;
+  }
+
+  view = MapViewOfFile(mapping, DYN_ARRAY_FILE_MAP_COPY, 0, 0, bytes);
+  CloseHandle(mapping); /* the view keeps the mapping alive */
+
+  return view;
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_file_unmap_view(void *view, dyn_array_usize bytes)
+{
+  (void)bytes;
+  UnmapViewOfFile(view);
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE int dyn_array_file_resize(dyn_array_file_handle file, dyn_array_u64 bytes)
+{
+  return dyn_array_file_seek(file, bytes) && SetEndOfFile(file);
+}
+
+/* Shared (written back to the file) view of the first "bytes" of the file. A file shorter than "bytes" is extended */
+DYN_ARRAY_API DYN_ARRAY_INLINE void *dyn_array_file_map_shared(dyn_array_file_handle file, dyn_array_usize bytes)
+{
+  void *view;
+  void *mapping = CreateFileMappingA(file, DYN_ARRAY_NULL, DYN_ARRAY_PAGE_READWRITE, (unsigned long)((dyn_array_u64)bytes >> 32), (unsigned long)(bytes & 0xFFFFFFFFUL), DYN_ARRAY_NULL);
+
+  if (!mapping)
+  {
+    return DYN_ARRAY_NULL;
+  }
+
+  view = MapViewOfFile(mapping, DYN_ARRAY_FILE_MAP_WRITE, 0, 0, bytes);
+  CloseHandle(mapping);
+
+  return view;
+}
+
+/* Extends the file to "bytes" and maps it again. SetEndOfFile fails while a view is mapped, but a mapping larger
+   than the file extends it. The old view is released once the new one exists, so it stays valid if mapping fails */
+DYN_ARRAY_API DYN_ARRAY_INLINE void *dyn_array_file_remap(dyn_array_file_handle file, void *view, dyn_array_usize old_bytes, dyn_array_usize bytes)
+{
+  void *b = dyn_array_file_map_shared(file, bytes);
+
+  (void)old_bytes;
+
+  if (b)
+  {
+    UnmapViewOfFile(view);
+  }
+
+  return b;
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE int dyn_array_file_sync(dyn_array_file_handle file, void *view, dyn_array_usize bytes)
+{
+  return FlushViewOfFile(view, bytes) && FlushFileBuffers(file);
+}
+#else
+typedef int dyn_array_file_handle;
+#define DYN_ARRAY_FILE_INVALID (-1)
+
+DYN_ARRAY_API DYN_ARRAY_INLINE dyn_array_file_handle dyn_array_file_open(const char *path, int mode)
+{
+  if (mode == DYN_ARRAY_FILE_READ)
+  {
+    return open(path, DYN_ARRAY_O_RDONLY);
+  }
+
+  return open(path, mode == DYN_ARRAY_FILE_WRITE ? DYN_ARRAY_O_WRONLY | DYN_ARRAY_O_CREAT | DYN_ARRAY_O_TRUNC : DYN_ARRAY_O_RDWR | DYN_ARRAY_O_CREAT, 0644);
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_file_close(dyn_array_file_handle file)
+{
+  close(file);
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE int dyn_array_file_read(dyn_array_file_handle file, void *buffer, dyn_array_usize bytes)
+{
+  char *b = (char *)buffer;
+
+  while (bytes)
+  {
+    dyn_array_ssize done = read(file, b, bytes < DYN_ARRAY_FILE_CHUNK ? bytes : DYN_ARRAY_FILE_CHUNK);
+
+    if (done <= 0)
+    {
+      return 0;
+    }
+
+    b += done;
+    bytes -= (dyn_array_usize)done;
+  }
+
+  return 1;
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE int dyn_array_file_write(dyn_array_file_handle file, const void *buffer, dyn_array_usize bytes)
+{
+  const char *b = (const char *)buffer;
+
+  while (bytes)
+  {
+    dyn_array_ssize done = write(file, b, bytes < DYN_ARRAY_FILE_CHUNK ? bytes : DYN_ARRAY_FILE_CHUNK);
+
+    if (done <= 0)
+    {
+      return 0;
+    }
+
+    b += done;
+    bytes -= (dyn_array_usize)done;
+  }
+
+  return 1;
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE int dyn_array_file_seek(dyn_array_file_handle file, dyn_array_u64 offset)
+{
+  return (dyn_array_u64)(dyn_array_off)offset == offset && lseek(file, (dyn_array_off)offset, DYN_ARRAY_SEEK_SET) == (dyn_array_off)offset;
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE dyn_array_u64 dyn_array_file_size(dyn_array_file_handle file)
+{
+  dyn_array_off size = lseek(file, 0, DYN_ARRAY_SEEK_END);
+  return size < 0 ? 0 : (dyn_array_u64)size;
+}
+
+/* Private (copy on write) mapping of the first "bytes" of the file */
+DYN_ARRAY_API DYN_ARRAY_INLINE void *dyn_array_file_map_view(dyn_array_file_handle file, dyn_array_usize bytes)
+{
+  void *view = mmap(DYN_ARRAY_NULL, bytes, DYN_ARRAY_PROT_READ | DYN_ARRAY_PROT_WRITE, DYN_ARRAY_MAP_PRIVATE, file, 0);
+  return view == DYN_ARRAY_MAP_FAILED ? DYN_ARRAY_NULL : view;
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_file_unmap_view(void *view, dyn_array_usize bytes)
+{
+  munmap(view, bytes);
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE int dyn_array_file_resize(dyn_array_file_handle file, dyn_array_u64 bytes)
+{
+  return (dyn_array_u64)(dyn_array_off)bytes == bytes && ftruncate(file, (dyn_array_off)bytes) == 0;
+}
+
+/* Shared (written back to the file) mapping of the first "bytes" of the file */
+DYN_ARRAY_API DYN_ARRAY_INLINE void *dyn_array_file_map_shared(dyn_array_file_handle file, dyn_array_usize bytes)
+{
+  void *view = mmap(DYN_ARRAY_NULL, bytes, DYN_ARRAY_PROT_READ | DYN_ARRAY_PROT_WRITE, DYN_ARRAY_MAP_SHARED, file, 0);
+  return view == DYN_ARRAY_MAP_FAILED ? DYN_ARRAY_NULL : view;
+}
+
+/* Extends the file to "bytes" and maps it again. On linux mremap moves the page tables instead of faulting
+   the mapped pages in again */
+DYN_ARRAY_API DYN_ARRAY_INLINE void *dyn_array_file_remap(dyn_array_file_handle file, void *view, dyn_array_usize old_bytes, dyn_array_usize bytes)
+{
+  void *b;
+
+  if (!dyn_array_file_resize(file, bytes))
+  {
+    return DYN_ARRAY_NULL;
+  }
+
+#ifdef __linux__
+  b = mremap(view, old_bytes, bytes, DYN_ARRAY_MREMAP_MAYMOVE);
+  b = b == DYN_ARRAY_MAP_FAILED ? DYN_ARRAY_NULL : b;
+#else
+  b = dyn_array_file_map_shared(file, bytes);
+
+  if (b)
+  {
+    munmap(view, old_bytes);
+  }
+#endif
+
+  return b;
+}
+
+DYN_ARRAY_API DYN_ARRAY_INLINE int dyn_array_file_sync(dyn_array_file_handle file, void *view, dyn_array_usize bytes)
+{
+  (void)file;
+  return msync(view, bytes, DYN_ARRAY_MS_SYNC) == 0;
+}
+#endif
+
+/* Reads and validates the header of an open file. Returns 0 if it does not describe "type_size" elements */
+DYN_ARRAY_API DYN_ARRAY_INLINE int dyn_array_file_read_header(dyn_array_file_handle file, dyn_array_file_header *header, dyn_array_usize type_size)
+{
+  const char *magic = DYN_ARRAY_FILE_MAGIC;
+  dyn_array_u64 size;
+  unsigned int i;
+
+  if (!dyn_array_file_read(file, header, sizeof(dyn_array_file_header)))
+  {
+    return 0;
+  }
+
+  for (i = 0; i < sizeof(header->magic); ++i)
+  {
+    if (header->magic[i] != magic[i])
+    {
+      return 0;
+    }
+  }
+
+  size = dyn_array_file_size(file);
+
+  return header->version == DYN_ARRAY_FILE_VERSION &&
+         header->endian == DYN_ARRAY_FILE_ENDIAN &&
+         header->type_size == type_size &&
+         header->data_offset >= sizeof(dyn_array_file_header) &&
+         header->data_offset <= size &&
+         header->length <= (size - header->data_offset) / type_size &&
+         header->length <= DYN_ARRAY_SIZE_MAX &&
+         header->length <= (DYN_ARRAY_USIZE_MAX - header->data_offset) / type_size;
+}
+
+/* Writes a header for "length" elements followed by the zero padding up to the element data */
+DYN_ARRAY_API DYN_ARRAY_INLINE int dyn_array_file_write_header(dyn_array_file_handle file, dyn_array_usize type_size, dyn_array_u64 length)
+{
+  static const char padding[256] = {0};
+  dyn_array_file_header header;
+  dyn_array_usize offset;
+  int ok;
+
+  dyn_array_memory_zero(&header, sizeof(header));
+  dyn_array_memory_copy(header.magic, DYN_ARRAY_FILE_MAGIC, sizeof(header.magic));
+  header.version = DYN_ARRAY_FILE_VERSION;
+  header.endian = DYN_ARRAY_FILE_ENDIAN;
+  header.type_size = type_size;
+  header.length = length;
+  header.alignment = DYN_ARRAY_FILE_ALIGNMENT;
+  header.data_offset = DYN_ARRAY_FILE_ALIGNMENT;
+
+  ok = dyn_array_file_write(file, &header, sizeof(header));
+
+  /* The padding is written (not seeked over) so even an empty array has all of its header bytes in the file */
+  for (offset = sizeof(header); ok && offset < DYN_ARRAY_FILE_ALIGNMENT; offset += sizeof(padding))
+  {
+    ok = dyn_array_file_write(file, padding, DYN_ARRAY_FILE_ALIGNMENT - offset < sizeof(padding) ? DYN_ARRAY_FILE_ALIGNMENT - offset : sizeof(padding));
+  }
+
+  return ok;
+}
+
+/* Writes the array to "path" (created or truncated). Returns 0 if the file could not be written */
+DYN_ARRAY_API DYN_ARRAY_INLINE int dyn_array_save_function(const char *path, const void *type, dyn_array_usize type_size)
+{
+  dyn_array_file_handle file = dyn_array_file_open(path, DYN_ARRAY_FILE_WRITE);
+  int ok;
+
+  if (file == DYN_ARRAY_FILE_INVALID)
+  {
+    return 0;
+  }
+
+  ok = dyn_array_file_write_header(file, type_size, dyn_array_length(type)) &&
+       dyn_array_file_write(file, type, (dyn_array_usize)dyn_array_length(type) * type_size);
+
+  dyn_array_file_close(file);
+
+  return ok;
+}
+
+/* Reads a file written by dyn_array_save into a new array. Returns NULL if it is missing or does not match */
+DYN_ARRAY_API DYN_ARRAY_INLINE void *dyn_array_load_function(const char *path, dyn_array_usize type_size)
+{
+  dyn_array_file_header header;
+  dyn_array_file_handle file = dyn_array_file_open(path, DYN_ARRAY_FILE_READ);
+  void *type = DYN_ARRAY_NULL;
+
+  if (file == DYN_ARRAY_FILE_INVALID)
+  {
+    return DYN_ARRAY_NULL;
+  }
+
+  if (dyn_array_file_read_header(file, &header, type_size) && dyn_array_file_seek(file, header.data_offset))
+  {
+    type = dyn_array_grow_function(DYN_ARRAY_NULL, type_size, (dyn_array_size)header.length, 0);
+
+    if (type && !dyn_array_file_read(file, type, (dyn_array_usize)header.length * type_size))
+    {
+      dyn_array_free_function(dyn_array_header(type), type_size);
+      type = DYN_ARRAY_NULL;
+    }
+
+    if (type)
+    {
+      dyn_array_header(type)->length = (dyn_array_size)header.length;
+    }
+  }
+
+  dyn_array_file_close(file);
+
+  return type;
+}
+
+#ifndef DYN_ARRAY_HEADER_COMPACT
+/* The dyn_array_storage of a mapped file. It lives in the padding of a private view (dyn_array_map) or is
+   allocated (persistent arrays) */
+typedef struct dyn_array_file_storage
+{
+  dyn_array_storage storage;
+  dyn_array_file_header *view;
+  dyn_array_usize mapped; /* bytes of the view */
+  dyn_array_file_handle file;
+
+} dyn_array_file_storage;
+
+/* Reads the header of an open file and checks that the file header, a dyn_array_file_storage and the dyn_array
+   header fit in front of element 0 which has to be aligned as configured */
+DYN_ARRAY_API DYN_ARRAY_INLINE int dyn_array_file_read_mappable_header(dyn_array_file_handle file, dyn_array_file_header *header, dyn_array_usize type_size)
+{
+  return dyn_array_file_read_header(file, header, type_size) &&
+         header->data_offset >= sizeof(dyn_array_file_header) + sizeof(dyn_array_file_storage) + DYN_ARRAY_HEADER_SIZE &&
+         header->data_offset % DYN_ARRAY_FILE_ALIGNMENT == 0;
+}
+
+/* Places the dyn_array header for "capacity" elements in front of element 0 of a view */
+DYN_ARRAY_API DYN_ARRAY_INLINE void *dyn_array_file_view_array(char *view, dyn_array_file_storage *storage, dyn_array_usize type_size, dyn_array_usize capacity, dyn_array_size length)
+{
+  dyn_array_usize offset = (dyn_array_usize)((dyn_array_file_header *)view)->data_offset;
+  void *type = dyn_array_init_buffer_function(view + offset - DYN_ARRAY_HEADER_SIZE, type_size, DYN_ARRAY_HEADER_SIZE + type_size * capacity);
+
+  dyn_array_header(type)->length = length;
+  dyn_array_header(type)->data = storage;
+
+  return type;
+}
+
+/* Growing a mapped array moves it into owned memory and releases the mapping */
+DYN_ARRAY_API DYN_ARRAY_NOINLINE void *dyn_array_map_grow(void *type, dyn_array_usize type_size, dyn_array_size capacity)
+{
+  dyn_array_file_storage *storage = (dyn_array_file_storage *)dyn_array_header(type)->data;
+  dyn_array_size length = dyn_array_header(type)->length;
+  void *b = dyn_array_grow_function(DYN_ARRAY_NULL, type_size, capacity, 0);
+
+  if (b)
+  {
+    dyn_array_memory_copy(b, type, type_size * length);
+    dyn_array_header(b)->length = length;
+    dyn_array_file_unmap_view(storage->view, storage->mapped);
+  }
+
+  return b;
+}
+
+DYN_ARRAY_API DYN_ARRAY_NOINLINE void dyn_array_map_release(void *type, dyn_array_usize type_size)
+{
+  dyn_array_file_storage *storage = (dyn_array_file_storage *)dyn_array_header(type)->data;
+
+  (void)type_size;
+  dyn_array_file_unmap_view(storage->view, storage->mapped);
+}
+
+/* Maps a file written by dyn_array_save and returns its elements in place as an array with capacity == length.
+   The mapping is private: changes are never written back to the file. Growing moves the array into owned
+   memory. Returns NULL if the file is missing or does not match. */
+DYN_ARRAY_API DYN_ARRAY_INLINE void *dyn_array_map_function(const char *path, dyn_array_usize type_size)
+{
+  dyn_array_file_header header;
+  dyn_array_file_storage *storage;
+  dyn_array_file_handle file = dyn_array_file_open(path, DYN_ARRAY_FILE_READ);
+  char *view = DYN_ARRAY_NULL;
+  dyn_array_usize mapped = 0;
+
+  if (file == DYN_ARRAY_FILE_INVALID)
+  {
+    return DYN_ARRAY_NULL;
+  }
+
+  if (dyn_array_file_read_mappable_header(file, &header, type_size))
+  {
+    mapped = (dyn_array_usize)header.data_offset + (dyn_array_usize)header.length * type_size;
+    view = (char *)dyn_array_file_map_view(file, mapped);
+  }
+
+  dyn_array_file_close(file); /* the mapping stays valid */
+
+  if (!view)
+  {
+    return DYN_ARRAY_NULL;
+  }
+
+  storage = (dyn_array_file_storage *)(view + sizeof(dyn_array_file_header));
+  storage->storage.grow = dyn_array_map_grow;
+  storage->storage.release = dyn_array_map_release;
+  storage->view = (dyn_array_file_header *)view;
+  storage->mapped = mapped;
+  storage->file = DYN_ARRAY_FILE_INVALID;
+
+  return dyn_array_file_view_array(view, storage, type_size, (dyn_array_usize)header.length, (dyn_array_size)header.length);
+}
+
+/* Releases a mapped array, or frees it if it has grown into owned memory. Same as dyn_array_free */
+DYN_ARRAY_API DYN_ARRAY_INLINE void dyn_array_unmap_function(void *type, dyn_array_usize type_size)
+{
+  dyn_array_free_function(dyn_array_header(type), type_size);
+}
+
+#define dyn_array_map(t, path) (dyn_array_free(t), ((t) = dyn_array_map_function((path), sizeof *(t))) != DYN_ARRAY_NULL)
+#define dyn_array_unmap(t) ((void)((t) ? dyn_array_unmap_function((t), sizeof *(t)) : (void)0), (t) = DYN_ARRAY_NULL)
+
+/* #############################################################################
+ * # PERSISTENT ARRAY (file backed)
+ * #############################################################################
+ * A persistent array is a dyn_array whose elements live in a shared mapping of a file in the format above, so it
+ * is indexed, measured and appended to like any other array. Growing extends the file and maps it again instead
+ * of calling DYN_ARRAY_FUNCTION_REALLOC. The length in the file header is only updated by
+ * dyn_array_persistent_flush (after the elements are synced) and on close: after a crash the file holds the
+ * array as of the last flush and can also be read with dyn_array_load or dyn_array_map.
+ */
+DYN_ARRAY_API DYN_ARRAY_NOINLINE void *dyn_array_persistent_grow(void *type, dyn_array_usize type_size, dyn_array_size capacity)
+{
+  dyn_array_file_storage *storage = (dyn_array_file_storage *)dyn_array_header(type)->data;
+  dyn_array_usize offset = (dyn_array_usize)storage->view->data_offset;
+  dyn_array_usize mapped;
+  char *view;
+
+  if ((dyn_array_usize)capacity > (DYN_ARRAY_USIZE_MAX - offset - DYN_ARRAY_FILE_ALIGNMENT) / type_size)
+  {
+    return DYN_ARRAY_NULL;
+  }
+
+  /* The file grows in whole pages and the capacity covers all of them */
+  mapped = dyn_array_round_up(offset + type_size * capacity, DYN_ARRAY_FILE_ALIGNMENT);
+  view = (char *)dyn_array_file_remap(storage->file, storage->view, storage->mapped, mapped);
+
+  if (!view)
+  {
+    return DYN_ARRAY_NULL;
+  }
+
+  storage->view = (dyn_array_file_header *)view;
+  storage->mapped = mapped;
+
+  /* The dyn_array header is part of the mapped file and moved along with it */
+  type = view + offset;
+  capacity = (mapped - offset) / type_size > DYN_ARRAY_SIZE_MAX ? DYN_ARRAY_SIZE_MAX : (dyn_array_size)((mapped - offset) / type_size);
+  dyn_array_header(type)->capacity = capacity;
+
+  return type;
+}
+
+/* Syncs the elements to the file, then publishes the length in the file header. Returns 0 if syncing fails */
+DYN_ARRAY_API DYN_ARRAY_INLINE int dyn_array_persistent_flush_function(void *type)
+{
+  dyn_array_file_storage *storage = (dyn_array_file_storage *)dyn_array_header(type)->data;
+  int ok = dyn_array_file_sync(storage->file, storage->view, storage->mapped);
+
+  storage->view->length = dyn_array_header(type)->length;
+
+  return dyn_array_file_sync(storage->file, storage->view, sizeof(dyn_array_file_header)) && ok;
+}
+
+/* Flushes, unmaps and trims the file to the length of the array. Returns 0 if flushing or trimming fails */
+DYN_ARRAY_API DYN_ARRAY_INLINE int dyn_array_persistent_close_function(void *type, dyn_array_usize type_size)
+{
+  dyn_array_file_storage *storage = (dyn_array_file_storage *)dyn_array_header(type)->data;
+  dyn_array_u64 used = storage->view->data_offset + (dyn_array_u64)dyn_array_header(type)->length * type_size;
+  int ok = dyn_array_persistent_flush_function(type);
+
+  dyn_array_file_unmap_view(storage->view, storage->mapped);
+  ok = dyn_array_file_resize(storage->file, used) && ok;
+  dyn_array_file_close(storage->file);
+  DYN_ARRAY_FUNCTION_FREE(storage);
+
+  return ok;
+}
+
+/* dyn_array_free on a persistent array closes it like dyn_array_persistent_close */
+DYN_ARRAY_API DYN_ARRAY_NOINLINE void dyn_array_persistent_release(void *type, dyn_array_usize type_size)
+{
+  (void)dyn_array_persistent_close_function(type, type_size);
+}
+
+/* Opens (or creates) a persistent array file. Returns NULL if it can not be opened or does not match */
+DYN_ARRAY_API DYN_ARRAY_INLINE void *dyn_array_persistent_open_function(const char *path, dyn_array_usize type_size)
+{
+  dyn_array_file_header header;
+  dyn_array_file_storage *storage = DYN_ARRAY_NULL;
+  dyn_array_file_handle file = dyn_array_file_open(path, DYN_ARRAY_FILE_UPDATE);
+  dyn_array_u64 size;
+  char *view = DYN_ARRAY_NULL;
+
+  if (file == DYN_ARRAY_FILE_INVALID)
+  {
+    return DYN_ARRAY_NULL;
+  }
+
+  /* A new file starts as an empty array */
+  if ((dyn_array_file_size(file) || dyn_array_file_write_header(file, type_size, 0)) && dyn_array_file_seek(file, 0) &&
+      dyn_array_file_read_mappable_header(file, &header, type_size))
+  {
+    size = dyn_array_file_size(file);
+    storage = (dyn_array_file_storage *)DYN_ARRAY_FUNCTION_REALLOC(DYN_ARRAY_NULL, sizeof(dyn_array_file_storage));
+    view = storage && (dyn_array_u64)(dyn_array_usize)size == size ? (char *)dyn_array_file_map_shared(file, (dyn_array_usize)size) : DYN_ARRAY_NULL;
+  }
+
+  if (!view)
+  {
+    if (storage)
+    {
+      DYN_ARRAY_FUNCTION_FREE(storage);
+    }
+    dyn_array_file_close(file);
+    return DYN_ARRAY_NULL;
+  }
+
+  storage->storage.grow = dyn_array_persistent_grow;
+  storage->storage.release = dyn_array_persistent_release;
+  storage->view = (dyn_array_file_header *)view;
+  storage->mapped = (dyn_array_usize)size;
+  storage->file = file;
+
+  /* Everything behind the flushed length is unused capacity */
+  return dyn_array_file_view_array(view, storage, type_size, (dyn_array_usize)((size - header.data_offset) / type_size), (dyn_array_size)header.length);
+}
+
+#define dyn_array_persistent_open(t, path) (dyn_array_free(t), ((t) = dyn_array_persistent_open_function((path), sizeof *(t))) != DYN_ARRAY_NULL)
+#define dyn_array_persistent_flush(t) ((t) ? dyn_array_persistent_flush_function(t) : 0)
+#define dyn_array_persistent_close(t) ((void)((t) ? dyn_array_persistent_close_function((t), sizeof *(t)) : 0), (t) = DYN_ARRAY_NULL)
+#endif
+
+#define dyn_array_save(t, path) dyn_array_save_function((path), (t), sizeof *(t))
+#define dyn_array_load(t, path) (dyn_array_free(t), ((t) = dyn_array_load_function((path), sizeof *(t))) != DYN_ARRAY_NULL)
+
+#endif /* DYN_ARRAY_FILE */
+
+/* #############################################################################
+ * # TRACE DUMP
+ * #############################################################################
+ */
+#ifdef DYN_ARRAY_TRACE
+
+#define DYN_ARRAY_TRACE_MAGIC "DYNTRACE"
+#define DYN_ARRAY_TRACE_VERSION 1u
+
+/* Followed by the file names (unsigned int length, then the characters) and the events, oldest first */
+typedef struct dyn_array_trace_header
+{
+  char magic[8]; /* "DYNTRACE", not terminated */
+  unsigned int version;
+  unsigned int endian;     /* DYN_ARRAY_FILE_ENDIAN in the byte order of the writer */
+  unsigned int event_size; /* sizeof(dyn_array_trace_event) */
+  unsigned int files;
+  dyn_array_u64 events;
+  dyn_array_u64 dropped;   /* Overwritten in the ring before the dump */
+  dyn_array_u64 frequency; /* DYN_ARRAY_TRACE_CLOCK_FREQUENCY() */
+
+} dyn_array_trace_header;
+
+/* Writes the events of this translation unit. Events recorded while dumping may be torn. Returns 0 if writing fails */
+DYN_ARRAY_API DYN_ARRAY_NOINLINE int dyn_array_trace_dump(const char *path)
+{
+  dyn_array_trace_header header;
+  dyn_array_usize recorded = DYN_ARRAY_ATOMIC_LOAD(&dyn_array_trace_global.recorded);
+  dyn_array_usize kept = recorded < DYN_ARRAY_TRACE_EVENTS ? recorded : DYN_ARRAY_TRACE_EVENTS;
+  dyn_array_usize first = (recorded - kept) & (DYN_ARRAY_TRACE_EVENTS - 1);
+  dyn_array_usize tail = kept < DYN_ARRAY_TRACE_EVENTS - first ? kept : DYN_ARRAY_TRACE_EVENTS - first;
+  dyn_array_file_handle file;
+  unsigned int i;
+  int ok;
+
+  dyn_array_memory_zero(&header, sizeof(header));
+  dyn_array_memory_copy(header.magic, DYN_ARRAY_TRACE_MAGIC, sizeof(header.magic));
+  header.version = DYN_ARRAY_TRACE_VERSION;
+  header.endian = DYN_ARRAY_FILE_ENDIAN;
+  header.event_size = (unsigned int)sizeof(dyn_array_trace_event);
+  header.events = kept;
+  header.dropped = recorded - kept;
+  header.frequency = DYN_ARRAY_TRACE_CLOCK_FREQUENCY();
+
+  while (header.files < DYN_ARRAY_TRACE_FILES && DYN_ARRAY_ATOMIC_LOAD(&dyn_array_trace_global.files[header.files]))
+  {
+    header.files++;
+  }
+
+  file = dyn_array_file_open(path, DYN_ARRAY_FILE_WRITE);
+
+  if (file == DYN_ARRAY_FILE_INVALID)
+  {
+    return 0;
+  }
+
+  ok = dyn_array_file_write(file, &header, sizeof(header));
+
+  for (i = 0; ok && i < header.files; ++i)
+  {
+    const char *name = dyn_array_trace_global.files[i];
+    unsigned int length = 0;
+
+    while (name[length])
+    {
+      length++;
+    }
+
+    ok = dyn_array_file_write(file, &length, sizeof(length)) && dyn_array_file_write(file, name, length);
+  }
+
+  /* The oldest event is at "first", the ring wraps around behind it */
+  ok = ok && dyn_array_file_write(file, &dyn_array_trace_global.events[first], tail * sizeof(dyn_array_trace_event));
+  ok = ok && dyn_array_file_write(file, dyn_array_trace_global.events, (kept - tail) * sizeof(dyn_array_trace_event));
+
+  dyn_array_file_close(file);
+
+  return ok;
+}
+
+#endif /* DYN_ARRAY_TRACE */
 
 #endif /* DYN_ARRAY_H */
 
@@ -0,0 +1,985 @@
+/* dyn_array.h - v0.1 - public domain data structures - nickscha 2025
+
+A C89 standard compliant, single header, nostdlib (no C Standard Library) dynamic generic array implementation.
+
+This Benchmark measures the time per element of the dyn_array operations across element and array sizes.
+
+The realloc/grow counters from DYN_ARRAY_COLLECT_STATISTICS are reported per repetition next to the timings
+so that changes in the growth behaviour are visible together with their cost.
+
+USAGE
+
+    dyn_array_bench [--json] [--backends] [--max-length N] [--max-bytes N] [--threads N]
+
+    --json          Print a JSON array instead of CSV
+    --backends      Benchmark the realloc backends growing a single block from 1MB up to --max-bytes
+                    instead of the dyn_array operations. Reports the total and the worst single realloc.
+    --max-length N  Skip array lengths above N elements      (Default: 100000000)
+    --max-bytes N   Skip runs whose array would exceed N bytes (Default: 1073741824)
+                    Use --backends --max-bytes 8589934592 for the 1MB - 8GB backend comparison.
+    --threads N     Parallel reduce with 1, 2, 4 ... N threads (Default: number of CPUs)
+    --contention    Multi producer append with 1, 2, 4 ... 64 threads: dyn_array_concurrent against a
+                    dyn_array behind a mutex, instead of the dyn_array operations
+
+LICENSE
+
+  Placed in the public domain and also MIT licensed.
+  See end of file for detailed license information.
+
+*/
+#define DYN_ARRAY_COLLECT_STATISTICS
+#define DYN_ARRAY_PARALLEL
+#define DYN_ARRAY_CONCURRENT
+#define DYN_ARRAY_FILE
+#define DYN_ARRAY_VIRTUAL_MEMORY
+#ifdef __linux__
+#define DYN_ARRAY_MREMAP
+#endif
+#include "../dyn_array.h"
+
+#include "perf.h" /* Simple timing helper */
+
+#include <stdio.h>
+
+/* Aim for this many element operations per measurement so small arrays are repeated often enough */
+#define BENCH_TARGET_ELEMENTS 16777216.0
+
+/* Number of elements passed per dyn_array_add_array call (typical ingest batch size) */
+#define BENCH_BATCH 4096
+
+typedef struct bench_type_16
+{
+    double a;
+    double b;
+} bench_type_16;
+
+typedef struct bench_type_64
+{
+    double v[8];
+} bench_type_64;
+
+typedef struct bench_config
+{
+    int json;
+    int backends;
+    double max_length;
+    double max_bytes;
+    unsigned int results;
+    unsigned int threads;
+    int contention;
+} bench_config;
+
+static bench_config config = {0, 0, 100000000.0, 1073741824.0, 0, 0, 0};
+
+static const unsigned int bench_lengths[] = {16, 256, 4096, 65536, 1048576, 16777216, 100000000};
+
+static volatile unsigned char bench_sink;
+
+static void bench_report(const char *op, unsigned int elem_size, unsigned int length, unsigned int reps, double ns)
+{
+    double elements = (double)length * (double)reps;
+
+    if (config.json)
+    {
+        printf("%s\n  {\"op\": \"%s\", \"elem_size\": %u, \"length\": %u, \"reps\": %u, \"ns_total\": %.0f, \"ns_per_element\": %.4f, "
+               "\"init_per_rep\": %.2f, \"realloc_per_rep\": %.2f, \"grow_per_rep\": %.2f}",
+               config.results ? "," : "",
+               op, elem_size, length, reps, ns, ns / elements,
+               (double)dyn_array_stats_init / (double)reps,
+               (double)dyn_array_stats_realloc / (double)reps,
+               (double)dyn_array_stats_grow_with_factor / (double)reps);
+    }
+    else
+    {
+        printf("%s,%u,%u,%u,%.0f,%.4f,%.2f,%.2f,%.2f\n",
+               op, elem_size, length, reps, ns, ns / elements,
+               (double)dyn_array_stats_init / (double)reps,
+               (double)dyn_array_stats_realloc / (double)reps,
+               (double)dyn_array_stats_grow_with_factor / (double)reps);
+    }
+
+    config.results++;
+}
+
+/* Every element type gets its own set of typed benchmark functions since dyn_array is macro based */
+#define BENCH_DEFINE(name, type)                                                        \
+    static void bench_##name(unsigned int length, unsigned int reps)                    \
+    {                                                                                   \
+        static type value;                                                              \
+        type *array = NULL;                                                             \
+        type *source = NULL;                                                            \
+        type **segmented = NULL;                                                        \
+        type *deque = NULL;                                                             \
+        dyn_array_usize storage[DYN_ARRAY_BUFFER_WORDS(type, 16)];                      \
+        unsigned int i;                                                                 \
+        unsigned int r;                                                                 \
+        double t0;                                                                      \
+        double ns = 0.0;                                                                \
+                                                                                        \
+        /* dyn_array_add starting from an empty array */                                \
+        dyn_array_stats_reset();                                                        \
+        for (r = 0; r < reps; ++r)                                                      \
+        {                                                                               \
+            t0 = perf_ticks();                                                          \
+            for (i = 0; i < length; ++i)                                                \
+            {                                                                           \
+                dyn_array_add(array, value);                                            \
+            }                                                                           \
+            ns += perf_ns(t0, perf_ticks());                                            \
+            bench_sink ^= *(unsigned char *)&array[length - 1];                         \
+            dyn_array_free(array);                                                      \
+        }                                                                               \
+        bench_report("add", (unsigned int)sizeof(type), length, reps, ns);              \
+                                                                                        \
+        /* dyn_array_add starting from a caller provided buffer with room for 16 elements */\
+        ns = 0.0;                                                                       \
+        dyn_array_stats_reset();                                                        \
+        for (r = 0; r < reps; ++r)                                                      \
+        {                                                                               \
+            t0 = perf_ticks();                                                          \
+            dyn_array_init_buffer(array, storage, sizeof(storage));                     \
+            for (i = 0; i < length; ++i)                                                \
+            {                                                                           \
+                dyn_array_add(array, value);                                            \
+            }                                                                           \
+            ns += perf_ns(t0, perf_ticks());                                            \
+            bench_sink ^= *(unsigned char *)&array[length - 1];                         \
+            dyn_array_free(array);                                                      \
+        }                                                                               \
+        bench_report("buffer_add", (unsigned int)sizeof(type), length, reps, ns);       \
+                                                                                        \
+        /* dyn_array_segmented_add: new blocks are allocated, nothing is copied */      \
+        ns = 0.0;                                                                       \
+        dyn_array_stats_reset();                                                        \
+        for (r = 0; r < reps; ++r)                                                      \
+        {                                                                               \
+            t0 = perf_ticks();                                                          \
+            for (i = 0; i < length; ++i)                                                \
+            {                                                                           \
+                dyn_array_segmented_add(segmented, value);                              \
+            }                                                                           \
+            ns += perf_ns(t0, perf_ticks());                                            \
+            bench_sink ^= *(unsigned char *)&dyn_array_segmented_last(segmented);       \
+            dyn_array_segmented_free(segmented);                                        \
+        }                                                                               \
+        bench_report("segmented_add", (unsigned int)sizeof(type), length, reps, ns);    \
+                                                                                        \
+        /* dyn_array_deque_push_back starting from an empty deque */                    \
+        ns = 0.0;                                                                       \
+        dyn_array_stats_reset();                                                        \
+        for (r = 0; r < reps; ++r)                                                      \
+        {                                                                               \
+            t0 = perf_ticks();                                                          \
+            for (i = 0; i < length; ++i)                                                \
+            {                                                                           \
+                dyn_array_deque_push_back(deque, value);                                \
+            }                                                                           \
+            ns += perf_ns(t0, perf_ticks());                                            \
+            bench_sink ^= *(unsigned char *)&dyn_array_deque_back(deque);               \
+            dyn_array_deque_free(deque);                                                \
+        }                                                                               \
+        bench_report("deque_push_back", (unsigned int)sizeof(type), length, reps, ns);  \
+                                                                                        \
+        /* FIFO window of "length" elements: push_back and pop_front per element */     \
+        ns = 0.0;                                                                       \
+        for (i = 0; i < length; ++i)                                                    \
+        {                                                                               \
+            dyn_array_deque_push_back(deque, value);                                    \
+        }                                                                               \
+        dyn_array_stats_reset();                                                        \
+        for (r = 0; r < reps; ++r)                                                      \
+        {                                                                               \
+            t0 = perf_ticks();                                                          \
+            for (i = 0; i < length; ++i)                                                \
+            {                                                                           \
+                value = dyn_array_deque_pop_front(deque);                               \
+                dyn_array_deque_push_back(deque, value);                                \
+            }                                                                           \
+            ns += perf_ns(t0, perf_ticks());                                            \
+            bench_sink ^= *(unsigned char *)&dyn_array_deque_front(deque);              \
+        }                                                                               \
+        bench_report("deque_window", (unsigned int)sizeof(type), length, reps, ns);     \
+        dyn_array_deque_free(deque);                                                    \
+                                                                                        \
+        /* dyn_array_add_array in batches of BENCH_BATCH elements */                    \
+        dyn_array_init(source, length);                                                 \
+        for (i = 0; i < length; ++i)                                                    \
+        {                                                                               \
+            dyn_array_add(source, value);                                               \
+        }                                                                               \
+        ns = 0.0;                                                                       \
+        dyn_array_stats_reset();                                                        \
+        for (r = 0; r < reps; ++r)                                                      \
+        {                                                                               \
+            t0 = perf_ticks();                                                          \
+            for (i = 0; i < length; i += BENCH_BATCH)                                   \
+            {                                                                           \
+                unsigned int count = length - i < BENCH_BATCH ? length - i : BENCH_BATCH; \
+                dyn_array_add_array(array, source + i, count);                          \
+            }                                                                           \
+            ns += perf_ns(t0, perf_ticks());                                            \
+            bench_sink ^= *(unsigned char *)&array[length - 1];                         \
+            dyn_array_free(array);                                                      \
+        }                                                                               \
+        bench_report("add_array", (unsigned int)sizeof(type), length, reps, ns);        \
+        dyn_array_free(source);                                                         \
+                                                                                        \
+        /* dyn_array_init with the final capacity followed by dyn_array_add */          \
+        ns = 0.0;                                                                       \
+        dyn_array_stats_reset();                                                        \
+        for (r = 0; r < reps; ++r)                                                      \
+        {                                                                               \
+            t0 = perf_ticks();                                                          \
+            dyn_array_init(array, length);                                              \
+            for (i = 0; i < length; ++i)                                                \
+            {                                                                           \
+                dyn_array_add(array, value);                                            \
+            }                                                                           \
+            ns += perf_ns(t0, perf_ticks());                                            \
+            bench_sink ^= *(unsigned char *)&array[length - 1];                         \
+            dyn_array_free(array);                                                      \
+        }                                                                               \
+        bench_report("init_fill", (unsigned int)sizeof(type), length, reps, ns);        \
+                                                                                        \
+        /* dyn_array_reserve with the final capacity followed by dyn_array_add_unchecked */ \
+        ns = 0.0;                                                                       \
+        dyn_array_stats_reset();                                                        \
+        for (r = 0; r < reps; ++r)                                                      \
+        {                                                                               \
+            t0 = perf_ticks();                                                          \
+            dyn_array_reserve(array, length);                                           \
+            for (i = 0; i < length; ++i)                                                \
+            {                                                                           \
+                dyn_array_add_unchecked(array, value);                                  \
+            }                                                                           \
+            ns += perf_ns(t0, perf_ticks());                                            \
+            bench_sink ^= *(unsigned char *)&array[length - 1];                         \
+            dyn_array_free(array);                                                      \
+        }                                                                               \
+        bench_report("add_unchecked", (unsigned int)sizeof(type), length, reps, ns);    \
+                                                                                        \
+        /* dyn_array_del of every element of a filled array */                         \
+        ns = 0.0;                                                                       \
+        dyn_array_init(array, length);                                                  \
+        dyn_array_stats_reset();                                                        \
+        for (r = 0; r < reps; ++r)                                                      \
+        {                                                                               \
+            for (i = 0; i < length; ++i)                                                \
+            {                                                                           \
+                dyn_array_add(array, value);                                            \
+            }                                                                           \
+            t0 = perf_ticks();                                                          \
+            for (i = 0; i < length; ++i)                                                \
+            {                                                                           \
+                dyn_array_del(array);                                                   \
+            }                                                                           \
+            ns += perf_ns(t0, perf_ticks());                                            \
+            bench_sink ^= (unsigned char)dyn_array_length(array);                       \
+        }                                                                               \
+        bench_report("del", (unsigned int)sizeof(type), length, reps, ns);              \
+        dyn_array_free(array);                                                          \
+    }
+
+BENCH_DEFINE(1, unsigned char)
+BENCH_DEFINE(4, int)
+BENCH_DEFINE(8, double)
+BENCH_DEFINE(16, bench_type_16)
+BENCH_DEFINE(64, bench_type_64)
+
+static int bench_compare_key(const void *a, const void *b)
+{
+    dyn_array_usize x = *(const dyn_array_usize *)a;
+    dyn_array_usize y = *(const dyn_array_usize *)b;
+
+    return (x > y) - (x < y);
+}
+
+/* Sorting of pointer sized (64-bit) random keys: dyn_array_sort, libc qsort and dyn_array_radix_sort */
+static void bench_sort(unsigned int length, unsigned int reps)
+{
+    dyn_array_usize *keys = NULL;
+    dyn_array_usize *array = NULL;
+    dyn_array_usize *scratch = NULL;
+    dyn_array_usize state = 1;
+    unsigned int i;
+    unsigned int r;
+    unsigned int op;
+    double t0;
+    double ns;
+
+    /* Two 32-bit LCG outputs per key. The double shift keeps 32-bit targets defined */
+    for (i = 0; i < length; ++i)
+    {
+        dyn_array_usize high;
+        state = state * 1664525u + 1013904223u;
+        high = state & 0xFFFFFFFFu;
+        state = state * 1664525u + 1013904223u;
+        dyn_array_add(keys, (high << 16 << 16) ^ (state & 0xFFFFFFFFu));
+    }
+
+    /* The scratch buffer of the radix sort is allocated once and reused like in a batch pipeline */
+    dyn_array_resize(array, length);
+    dyn_array_resize(scratch, length);
+    dyn_array_memory_zero(scratch, sizeof(dyn_array_usize) * length);
+
+    for (op = 0; op < 3; ++op)
+    {
+        ns = 0.0;
+        dyn_array_stats_reset();
+
+        for (r = 0; r < reps; ++r)
+        {
+            dyn_array_memory_copy(array, keys, sizeof(dyn_array_usize) * length);
+
+            t0 = perf_ticks();
+            if (op == 0)
+            {
+                dyn_array_sort(array, bench_compare_key);
+            }
+            else if (op == 1)
+            {
+                qsort(array, length, sizeof(dyn_array_usize), bench_compare_key);
+            }
+            else
+            {
+                dyn_array_radix_sort(array, scratch, DYN_ARRAY_KEY_UNSIGNED);
+            }
+            ns += perf_ns(t0, perf_ticks());
+
+            bench_sink ^= (unsigned char)array[length / 2];
+        }
+
+        bench_report(op == 0 ? "sort" : op == 1 ? "qsort" : "radix_sort", (unsigned int)sizeof(dyn_array_usize), length, reps, ns);
+    }
+
+    dyn_array_free(keys);
+    dyn_array_free(array);
+    dyn_array_free(scratch);
+}
+
+/* A record with 12 fields of which a hot scan reads 2, stored as array of structs and as struct of arrays */
+typedef struct bench_record
+{
+    float f[12];
+} bench_record;
+
+#define BENCH_RECORD_FIELDS(X) \
+    X(float, a)                \
+    X(float, b)                \
+    X(float, c)                \
+    X(float, d)                \
+    X(float, e)                \
+    X(float, f)                \
+    X(float, g)                \
+    X(float, h)                \
+    X(float, i)                \
+    X(float, j)                \
+    X(float, k)                \
+    X(float, l)
+DYN_ARRAY_SOA_DEFINE(bench_records, BENCH_RECORD_FIELDS)
+
+static void bench_soa(unsigned int length, unsigned int reps)
+{
+    bench_record *aos = NULL;
+    bench_record record;
+    bench_records soa;
+    float sum;
+    unsigned int i;
+    unsigned int r;
+    double t0;
+    double ns;
+    int op;
+
+    dyn_array_memory_zero(&record, sizeof(record));
+    bench_records_init(&soa);
+
+    for (i = 0; i < length; ++i)
+    {
+        record.f[0] = (float)(i & 1023);
+        record.f[1] = 1.0f;
+        dyn_array_add(aos, record);
+        bench_records_add(&soa, record.f[0], 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+    }
+
+    /* sum of a * b over all records */
+    for (op = 0; op < 2; ++op)
+    {
+        ns = 0.0;
+        dyn_array_stats_reset();
+        for (r = 0; r < reps; ++r)
+        {
+            sum = 0.0f;
+            t0 = perf_ticks();
+            if (op == 0)
+            {
+                for (i = 0; i < length; ++i)
+                {
+                    sum += aos[i].f[0] * aos[i].f[1];
+                }
+            }
+            else
+            {
+                for (i = 0; i < length; ++i)
+                {
+                    sum += soa.a[i] * soa.b[i];
+                }
+            }
+            ns += perf_ns(t0, perf_ticks());
+            bench_sink ^= (unsigned char)sum;
+        }
+        bench_report(op == 0 ? "scan_aos" : "scan_soa", (unsigned int)sizeof(bench_record), length, reps, ns);
+    }
+
+    dyn_array_free(aos);
+    bench_records_free(&soa);
+}
+
+/* dyn_array_save, dyn_array_load and dyn_array_map followed by a scan of every element (the page cache is warm)
+   and dyn_array_add to a persistent array starting from an empty file (including the final close) */
+static void bench_file(unsigned int length, unsigned int reps)
+{
+    const char *path = "dyn_array_bench.bin";
+    double *array = NULL;
+    double *loaded = NULL;
+    double sum;
+    unsigned int i;
+    unsigned int r;
+    double t0;
+    double ns;
+    int op;
+
+    for (i = 0; i < length; ++i)
+    {
+        dyn_array_add(array, (double)(i & 1023));
+    }
+
+    for (op = 0; op < 4; ++op)
+    {
+        ns = 0.0;
+        dyn_array_stats_reset();
+        for (r = 0; r < reps; ++r)
+        {
+            sum = 0.0;
+            t0 = perf_ticks();
+            if (op == 0)
+            {
+                bench_sink ^= (unsigned char)dyn_array_save(array, path);
+            }
+            else if (op == 3)
+            {
+                if (!dyn_array_save(loaded, path) || !dyn_array_persistent_open(loaded, path))
+                {
+                    return;
+                }
+                for (i = 0; i < length; ++i)
+                {
+                    dyn_array_add(loaded, (double)i);
+                }
+                dyn_array_persistent_close(loaded);
+            }
+            else
+            {
+                if (op == 1 ? !dyn_array_load(loaded, path) : !dyn_array_map(loaded, path))
+                {
+                    return;
+                }
+                for (i = 0; i < length; ++i)
+                {
+                    sum += loaded[i];
+                }
+                op == 1 ? dyn_array_free(loaded) : dyn_array_unmap(loaded);
+            }
+            ns += perf_ns(t0, perf_ticks());
+            bench_sink ^= (unsigned char)sum;
+        }
+        bench_report(op == 0 ? "file_save" : op == 1 ? "file_load_scan" : op == 2 ? "file_map_scan" : "persistent_add", (unsigned int)sizeof(double), length, reps, ns);
+    }
+
+    dyn_array_free(array);
+}
+
+/* Times "expression" over "reps" repetitions and folds its result into the sink */
+#define BENCH_NUMERIC(op, elem_size, expression)                    \
+    do                                                              \
+    {                                                               \
+        ns = 0.0;                                                   \
+        dyn_array_stats_reset();                                    \
+        for (r = 0; r < reps; ++r)                                  \
+        {                                                           \
+            t0 = perf_ticks();                                      \
+            bench_sink ^= (unsigned char)(expression);              \
+            ns += perf_ns(t0, perf_ticks());                        \
+        }                                                           \
+        bench_report(op, elem_size, length, reps, ns);              \
+    } while (0)
+
+/* Reductions and scans of the numeric kernels (SIMD unless compiled with -DDYN_ARRAY_NO_SIMD) */
+static void bench_numeric(unsigned int length, unsigned int reps)
+{
+    float *floats = NULL;
+    double *doubles = NULL;
+    int *ints = NULL;
+    unsigned int i;
+    unsigned int r;
+    double t0;
+    double ns;
+
+    for (i = 0; i < length; ++i)
+    {
+        dyn_array_add(floats, (float)(i & 1023));
+        dyn_array_add(doubles, (double)(i & 1023));
+        dyn_array_add(ints, (int)(i & 1023));
+    }
+
+    BENCH_NUMERIC("sum", 4, dyn_array_sum_float(floats));
+    BENCH_NUMERIC("sum", 8, dyn_array_sum_double(doubles));
+    BENCH_NUMERIC("sum_int", 4, dyn_array_sum_int(ints));
+    BENCH_NUMERIC("min", 4, dyn_array_min_float(floats));
+    BENCH_NUMERIC("dot", 4, dyn_array_dot_float(floats, floats));
+    BENCH_NUMERIC("dot", 8, dyn_array_dot_double(doubles, doubles));
+    BENCH_NUMERIC("count_int", 4, dyn_array_count_int(ints, 7));
+    BENCH_NUMERIC("find_int", 4, dyn_array_find_int(ints, -1));
+    BENCH_NUMERIC("fill_int", 4, (dyn_array_fill_int(ints, (int)r), ints[0]));
+
+    dyn_array_free(floats);
+    dyn_array_free(doubles);
+    dyn_array_free(ints);
+}
+
+static void bench_parallel_sum(const void *type, dyn_array_usize begin, dyn_array_usize end, void *partial, void *context)
+{
+    const int *ints = (const int *)type;
+    dyn_array_i64 sum = 0;
+
+    (void)context;
+
+    for (; begin < end; ++begin)
+    {
+        sum += ints[begin];
+    }
+
+    *(dyn_array_i64 *)partial += sum;
+}
+
+static void bench_parallel_add(void *result, const void *partial, void *context)
+{
+    (void)context;
+    *(dyn_array_i64 *)result += *(const dyn_array_i64 *)partial;
+}
+
+/* Scaling of dyn_array_parallel_reduce (int sum) over the thread count. Pool start up is not timed */
+static void bench_parallel(unsigned int length, unsigned int reps)
+{
+    int *ints = NULL;
+    unsigned int threads;
+    unsigned int i;
+
+    for (i = 0; i < length; ++i)
+    {
+        dyn_array_add(ints, (int)(i & 1023));
+    }
+
+    for (threads = 1; threads <= config.threads; threads = threads * 2 > config.threads && threads < config.threads ? config.threads : threads * 2)
+    {
+        dyn_array_parallel_pool *pool = dyn_array_parallel_create(threads);
+        char op[32];
+        unsigned int r;
+        double t0;
+        double ns = 0.0;
+
+        dyn_array_stats_reset();
+
+        for (r = 0; r < reps; ++r)
+        {
+            dyn_array_i64 sum = 0;
+            t0 = perf_ticks();
+            dyn_array_parallel_reduce(pool, ints, bench_parallel_sum, bench_parallel_add, &sum, NULL);
+            ns += perf_ns(t0, perf_ticks());
+            bench_sink ^= (unsigned char)sum;
+        }
+
+        sprintf(op, "parallel_sum_t%u", pool ? pool->thread_count : 1);
+        bench_report(op, 4, length, reps, ns);
+        dyn_array_parallel_destroy(pool);
+    }
+
+    dyn_array_free(ints);
+}
+
+#define BENCH_CONTENTION_ELEMENTS 4194304
+#define BENCH_CONTENTION_MAX_THREADS 64
+
+typedef struct bench_producer
+{
+    dyn_array_concurrent *concurrent;
+    unsigned int **locked;
+    DYN_ARRAY_MUTEX *mutex;
+    unsigned int count;
+    unsigned int id;
+} bench_producer;
+
+static void *bench_produce_concurrent(void *argument)
+{
+    bench_producer *producer = (bench_producer *)argument;
+    unsigned int i;
+
+    for (i = 0; i < producer->count; ++i)
+    {
+        unsigned int value = producer->id + i;
+        dyn_array_concurrent_add(producer->concurrent, &value);
+    }
+
+    return DYN_ARRAY_NULL;
+}
+
+static void *bench_produce_locked(void *argument)
+{
+    bench_producer *producer = (bench_producer *)argument;
+    unsigned int i;
+
+    for (i = 0; i < producer->count; ++i)
+    {
+        DYN_ARRAY_MUTEX_LOCK(*producer->mutex);
+        dyn_array_add(*producer->locked, producer->id + i);
+        DYN_ARRAY_MUTEX_UNLOCK(*producer->mutex);
+    }
+
+    return DYN_ARRAY_NULL;
+}
+
+/* BENCH_CONTENTION_ELEMENTS single element appends split over the threads into one shared array. The time
+   includes starting and joining the threads */
+static void bench_contention(void)
+{
+    static bench_producer producers[BENCH_CONTENTION_MAX_THREADS];
+    static DYN_ARRAY_THREAD threads[BENCH_CONTENTION_MAX_THREADS];
+    unsigned int thread_count;
+    int locked;
+
+    printf("%s", config.json ? "[" : "op,elem_size,length,reps,ns_total,ns_per_element,init_per_rep,realloc_per_rep,grow_per_rep\n");
+
+    for (thread_count = 1; thread_count <= BENCH_CONTENTION_MAX_THREADS; thread_count *= 2)
+    {
+        for (locked = 0; locked < 2; ++locked)
+        {
+            dyn_array_concurrent concurrent;
+            unsigned int *array = NULL;
+            DYN_ARRAY_MUTEX mutex;
+            unsigned int started = 0;
+            unsigned int i;
+            char op[32];
+            double t0;
+            double ns;
+
+            dyn_array_concurrent_init(&concurrent, sizeof(unsigned int));
+            DYN_ARRAY_MUTEX_INIT(mutex);
+            dyn_array_stats_reset();
+
+            t0 = perf_ticks();
+
+            for (i = 0; i < thread_count; ++i)
+            {
+                producers[i].concurrent = &concurrent;
+                producers[i].locked = &array;
+                producers[i].mutex = &mutex;
+                producers[i].count = BENCH_CONTENTION_ELEMENTS / thread_count;
+                producers[i].id = i << 24;
+
+                if (!DYN_ARRAY_THREAD_CREATE(threads[i], locked ? bench_produce_locked : bench_produce_concurrent, &producers[i]))
+                {
+                    break;
+                }
+
+                started++;
+            }
+
+            for (i = 0; i < started; ++i)
+            {
+                DYN_ARRAY_THREAD_JOIN(threads[i]);
+            }
+
+            ns = perf_ns(t0, perf_ticks());
+
+            sprintf(op, "%s_add_t%u", locked ? "mutex" : "concurrent", started);
+            bench_report(op, 4, (unsigned int)(locked ? dyn_array_length(array) : dyn_array_concurrent_length(&concurrent)), 1, ns);
+
+            dyn_array_concurrent_free(&concurrent);
+            dyn_array_free(array);
+            DYN_ARRAY_MUTEX_DESTROY(mutex);
+        }
+    }
+
+    printf("%s", config.json ? "\n]\n" : "");
+}
+
+typedef void *(*bench_realloc_function)(void *pointer, dyn_array_usize size);
+typedef void (*bench_free_function)(void *pointer);
+
+static void *bench_libc_realloc(void *pointer, dyn_array_usize size)
+{
+    return realloc(pointer, size);
+}
+
+static void bench_libc_free(void *pointer)
+{
+    free(pointer);
+}
+
+/* Grows one block by 1.5x from 64KB up to "bytes" like an append only array does and touches every new page */
+static void bench_backend(const char *backend, bench_realloc_function realloc_function, bench_free_function free_function, dyn_array_usize bytes)
+{
+    dyn_array_usize size = 64 * 1024;
+    dyn_array_usize touched = 0;
+    unsigned int grows = 0;
+    double ns = 0.0;
+    double ns_max = 0.0;
+    char *block = (char *)realloc_function(DYN_ARRAY_NULL, size);
+
+    for (;;)
+    {
+        for (; touched < size; touched += 4096)
+        {
+            block[touched] = (char)touched;
+        }
+
+        if (size >= bytes)
+        {
+            break;
+        }
+
+        size = size + size / 2 < bytes ? size + size / 2 : bytes;
+
+        {
+            double t0 = perf_ticks();
+            double t;
+            block = (char *)realloc_function(block, size);
+            t = perf_ns(t0, perf_ticks());
+            ns += t;
+            ns_max = t > ns_max ? t : ns_max;
+            grows++;
+        }
+
+        if (!block)
+        {
+            printf("%s: realloc of %.0f bytes failed\n", backend, (double)size);
+            return;
+        }
+    }
+
+    bench_sink ^= (unsigned char)block[bytes / 2];
+    free_function(block);
+
+    if (config.json)
+    {
+        printf("%s\n  {\"backend\": \"%s\", \"bytes\": %.0f, \"grows\": %u, \"realloc_ns_total\": %.0f, \"realloc_ns_max\": %.0f}",
+               config.results ? "," : "", backend, (double)bytes, grows, ns, ns_max);
+    }
+    else
+    {
+        printf("%s,%.0f,%u,%.0f,%.0f\n", backend, (double)bytes, grows, ns, ns_max);
+    }
+
+    config.results++;
+}
+
+static void bench_backends(void)
+{
+    dyn_array_usize bytes;
+
+    printf("%s", config.json ? "[" : "backend,bytes,grows,realloc_ns_total,realloc_ns_max\n");
+
+    for (bytes = (dyn_array_usize)1024 * 1024; (double)bytes <= config.max_bytes; bytes *= 4)
+    {
+        bench_backend("libc", bench_libc_realloc, bench_libc_free, bytes);
+        bench_backend("vm", dyn_array_vm_realloc, dyn_array_vm_free, bytes);
+#ifdef DYN_ARRAY_MREMAP
+        bench_backend("mremap", dyn_array_mremap_realloc, dyn_array_mremap_free, bytes);
+#endif
+
+        if (bytes > ((dyn_array_usize)-1) / 4)
+        {
+            break;
+        }
+    }
+
+    printf("%s", config.json ? "\n]\n" : "");
+}
+
+static double bench_parse_number(const char *s)
+{
+    double value = 0.0;
+
+    while (*s >= '0' && *s <= '9')
+    {
+        value = value * 10.0 + (double)(*s - '0');
+        ++s;
+    }
+
+    return value;
+}
+
+static int bench_string_equals(const char *a, const char *b)
+{
+    while (*a && *a == *b)
+    {
+        ++a;
+        ++b;
+    }
+
+    return *a == *b;
+}
+
+int main(int argc, char **argv)
+{
+    int arg;
+    unsigned int l;
+
+    for (arg = 1; arg < argc; ++arg)
+    {
+        if (bench_string_equals(argv[arg], "--json"))
+        {
+            config.json = 1;
+        }
+        else if (bench_string_equals(argv[arg], "--backends"))
+        {
+            config.backends = 1;
+        }
+        else if (bench_string_equals(argv[arg], "--max-length") && arg + 1 < argc)
+        {
+            config.max_length = bench_parse_number(argv[++arg]);
+        }
+        else if (bench_string_equals(argv[arg], "--max-bytes") && arg + 1 < argc)
+        {
+            config.max_bytes = bench_parse_number(argv[++arg]);
+        }
+        else if (bench_string_equals(argv[arg], "--contention"))
+        {
+            config.contention = 1;
+        }
+        else if (bench_string_equals(argv[arg], "--threads") && arg + 1 < argc)
+        {
+            config.threads = (unsigned int)bench_parse_number(argv[++arg]);
+        }
+    }
+
+    perf_init();
+
+    if (config.threads == 0)
+    {
+        config.threads = DYN_ARRAY_CPU_COUNT();
+        config.threads = config.threads ? config.threads : 1;
+    }
+
+    if (config.backends)
+    {
+        bench_backends();
+        return (int)bench_sink * 0;
+    }
+
+    if (config.contention)
+    {
+        bench_contention();
+        return (int)bench_sink * 0;
+    }
+
+    printf("%s", config.json ? "[" : "op,elem_size,length,reps,ns_total,ns_per_element,init_per_rep,realloc_per_rep,grow_per_rep\n");
+
+    for (l = 0; l < sizeof(bench_lengths) / sizeof(bench_lengths[0]); ++l)
+    {
+        unsigned int length = bench_lengths[l];
+        double reps = BENCH_TARGET_ELEMENTS / (double)length;
+        unsigned int r = reps < 1.0 ? 1 : (unsigned int)reps;
+
+        if ((double)length > config.max_length)
+        {
+            continue;
+        }
+
+        if ((double)length * 1.0 <= config.max_bytes)
+        {
+            bench_1(length, r);
+        }
+        if ((double)length * 4.0 <= config.max_bytes)
+        {
+            bench_4(length, r);
+        }
+        if ((double)length * 8.0 <= config.max_bytes)
+        {
+            bench_8(length, r);
+        }
+        if ((double)length * 16.0 <= config.max_bytes)
+        {
+            bench_16(length, r);
+        }
+        if ((double)length * 64.0 <= config.max_bytes)
+        {
+            bench_64(length, r);
+        }
+        if ((double)length * 16.0 <= config.max_bytes && length <= 16777216)
+        {
+            bench_sort(length, r > 16 ? r / 16 : 1);
+        }
+        if ((double)length * 16.0 <= config.max_bytes && length <= 16777216)
+        {
+            bench_numeric(length, r);
+        }
+        if ((double)length * 4.0 <= config.max_bytes)
+        {
+            bench_parallel(length, r);
+        }
+        if ((double)length * 96.0 <= config.max_bytes)
+        {
+            bench_soa(length, r);
+        }
+        if ((double)length * 16.0 <= config.max_bytes && length <= 16777216)
+        {
+            bench_file(length, r > 64 ? r / 64 : 1);
+        }
+    }
+
+    printf("%s", config.json ? "\n]\n" : "");
+
+    return (int)bench_sink * 0;
+}
+
+/*
+   ------------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+*/
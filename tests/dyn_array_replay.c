@@ -0,0 +1,424 @@
+/* dyn_array.h - v0.1 - public domain data structures - nickscha 2025
+
+A C89 standard compliant, single header, nostdlib (no C Standard Library) dynamic generic array implementation.
+
+This Tool replays a growth trace recorded with DYN_ARRAY_TRACE (see dyn_array_trace_dump) against other growth
+factors and allocator backends so the growth strategy can be picked from the traces of real workloads.
+
+Each array of the trace is followed through its grows and frees. A grow which applied the growth factor is redone
+with the factor under test, exact capacities (init, reserve, shrink) are kept. An array whose creation was already
+overwritten in the ring starts from its recorded capacity. The backends are modelled by their block sizes and by
+the bytes they copy when a block grows:
+
+    realloc         blocks rounded to the malloc granularity, every grow copies the old block (worst case)
+    mremap          like realloc below 256KB, page rounded mappings above which grow without copying
+    virtual_memory  committed in 64KB steps within a reservation, never copies
+
+USAGE
+
+    dyn_array_replay trace.bin [--sites]
+
+    Prints CSV with one row per growth factor and backend:
+
+    policy,backend,reallocs,alloc_bytes,copied_bytes,peak_bytes
+
+    reallocs      Blocks allocated or resized
+    alloc_bytes   Sum of the sizes of these blocks
+    copied_bytes  Bytes copied from the old into the new blocks
+    peak_bytes    Highest sum of the live blocks
+
+    The "recorded" policy repeats the capacities of the trace itself as a reference.
+
+    --sites  Adds the rows per call site (file:line of the macro which grew the array) after the totals:
+
+             site,policy,backend,reallocs,alloc_bytes,copied_bytes
+
+LICENSE
+
+  Placed in the public domain and also MIT licensed.
+  See end of file for detailed license information.
+
+*/
+#define DYN_ARRAY_TRACE
+#include "../dyn_array.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* Defaults of DYN_ARRAY_MREMAP_THRESHOLD and DYN_ARRAY_VM_COMMIT_SIZE */
+#define REPLAY_MREMAP_THRESHOLD ((dyn_array_u64)256 * 1024)
+#define REPLAY_VM_COMMIT_SIZE ((dyn_array_u64)64 * 1024)
+
+#define REPLAY_ROUND_UP(v, a) (((v) + ((a) - 1)) / (a) * (a))
+
+typedef struct replay_policy
+{
+    const char *name;
+    dyn_array_u64 (*growth)(dyn_array_u64 capacity); /* NULL: the recorded capacities */
+} replay_policy;
+
+typedef struct replay_backend
+{
+    const char *name;
+    dyn_array_u64 (*block)(dyn_array_u64 bytes);
+    dyn_array_u64 (*copied)(dyn_array_u64 old_block, dyn_array_u64 new_block);
+} replay_backend;
+
+/* Live array of the simulation, keyed by the address the trace knows it by */
+typedef struct replay_slot
+{
+    dyn_array_u64 address; /* 0: empty, 1: removed */
+    dyn_array_u64 capacity;
+} replay_slot;
+
+typedef struct replay_site
+{
+    unsigned int file;
+    unsigned int line;
+    dyn_array_u64 reallocs;
+    dyn_array_u64 alloc_bytes;
+    dyn_array_u64 copied_bytes;
+} replay_site;
+
+typedef struct replay_result
+{
+    dyn_array_u64 reallocs;
+    dyn_array_u64 alloc_bytes;
+    dyn_array_u64 copied_bytes;
+    dyn_array_u64 live_bytes;
+    dyn_array_u64 peak_bytes;
+} replay_result;
+
+static dyn_array_u64 replay_grow_1_5x(dyn_array_u64 c) { return DYN_ARRAY_GROW_FACTOR_1_5X(c); }
+static dyn_array_u64 replay_grow_golden(dyn_array_u64 c) { return DYN_ARRAY_GROW_FACTOR_GOLDEN(c); }
+static dyn_array_u64 replay_grow_2x(dyn_array_u64 c) { return DYN_ARRAY_GROW_FACTOR_2X(c); }
+static dyn_array_u64 replay_grow_16(dyn_array_u64 c) { return (void)c, 16; }
+
+static const replay_policy replay_policies[] = {
+    {"recorded", NULL},
+    {"1.5x", replay_grow_1_5x},
+    {"golden", replay_grow_golden},
+    {"2x", replay_grow_2x},
+    {"+16", replay_grow_16}};
+
+static dyn_array_u64 replay_block_malloc(dyn_array_u64 bytes) { return DYN_ARRAY_GROW_ROUND_MALLOC(bytes); }
+static dyn_array_u64 replay_block_mremap(dyn_array_u64 bytes) { return bytes < REPLAY_MREMAP_THRESHOLD ? DYN_ARRAY_GROW_ROUND_MALLOC(bytes) : REPLAY_ROUND_UP(bytes, DYN_ARRAY_PAGE_SIZE); }
+static dyn_array_u64 replay_block_vm(dyn_array_u64 bytes) { return REPLAY_ROUND_UP(bytes, REPLAY_VM_COMMIT_SIZE); }
+
+static dyn_array_u64 replay_copied_realloc(dyn_array_u64 old_block, dyn_array_u64 new_block) { return old_block < new_block ? old_block : new_block; }
+static dyn_array_u64 replay_copied_mremap(dyn_array_u64 old_block, dyn_array_u64 new_block) { return old_block >= REPLAY_MREMAP_THRESHOLD && new_block >= REPLAY_MREMAP_THRESHOLD ? 0 : replay_copied_realloc(old_block, new_block); }
+static dyn_array_u64 replay_copied_none(dyn_array_u64 old_block, dyn_array_u64 new_block) { return (void)old_block, (void)new_block, 0; }
+
+static const replay_backend replay_backends[] = {
+    {"realloc", replay_block_malloc, replay_copied_realloc},
+    {"mremap", replay_block_mremap, replay_copied_mremap},
+    {"virtual_memory", replay_block_vm, replay_copied_none}};
+
+static dyn_array_trace_event *events = NULL;
+static char **files = NULL;
+static replay_slot *slots = NULL;
+static replay_site *sites = NULL;
+static unsigned int *event_sites = NULL;
+
+/* Open addressing on the array address. Every event inserts at most once, the table holds twice the events */
+static replay_slot *replay_find(dyn_array_u64 address)
+{
+    dyn_array_size mask = dyn_array_length(slots) - 1;
+    dyn_array_size i = (dyn_array_size)((address >> 4) ^ (address >> 16)) & mask;
+
+    while (slots[i].address && slots[i].address != address)
+    {
+        i = (i + 1) & mask;
+    }
+
+    return &slots[i];
+}
+
+static void replay_resize(const replay_backend *backend, replay_result *result, replay_site *site, dyn_array_u64 bytes_per_element, dyn_array_u64 capacity, dyn_array_u64 wanted)
+{
+    dyn_array_u64 header = DYN_ARRAY_ALLOCATION_OVERHEAD;
+    dyn_array_u64 old_block = capacity ? backend->block(capacity * bytes_per_element + header) : 0;
+    dyn_array_u64 new_block = backend->block(wanted * bytes_per_element + header);
+    dyn_array_u64 copied = old_block ? backend->copied(old_block, new_block) : 0;
+
+    result->reallocs++;
+    result->alloc_bytes += new_block;
+    result->copied_bytes += copied;
+    result->live_bytes += new_block - old_block;
+    result->peak_bytes = result->live_bytes > result->peak_bytes ? result->live_bytes : result->peak_bytes;
+
+    site->reallocs++;
+    site->alloc_bytes += new_block;
+    site->copied_bytes += copied;
+}
+
+static void replay_run(const replay_policy *policy, const replay_backend *backend, replay_result *result)
+{
+    dyn_array_size e;
+
+    dyn_array_memory_zero(result, sizeof(*result));
+    dyn_array_memory_zero(slots, dyn_array_length(slots) * sizeof(*slots));
+
+    for (e = 0; e < dyn_array_length(events); ++e)
+    {
+        const dyn_array_trace_event *event = &events[e];
+        replay_site *site = &sites[event_sites[e]];
+        replay_slot *slot = event->array ? replay_find(event->array) : NULL;
+        dyn_array_u64 header = DYN_ARRAY_ALLOCATION_OVERHEAD;
+        dyn_array_u64 capacity = slot && slot->address ? slot->capacity : 0;
+        dyn_array_u64 wanted;
+
+        if (slot && !slot->address && event->old_capacity)
+        {
+            /* Created before the oldest event in the ring */
+            capacity = event->old_capacity;
+            result->live_bytes += backend->block(capacity * event->type_size + header);
+        }
+
+        /* The trace only holds the grows of the recorded policy. A policy growing slower needs the grows in between,
+           assuming the elements arrived one at a time */
+        while (policy->growth && capacity && capacity < event->length)
+        {
+            dyn_array_u64 grown = capacity + 1 + policy->growth(capacity);
+            replay_resize(backend, result, site, event->type_size, capacity, grown);
+            capacity = grown;
+        }
+
+        if (event->kind == DYN_ARRAY_TRACE_FREE)
+        {
+            if (capacity)
+            {
+                result->live_bytes -= backend->block(capacity * event->type_size + header);
+            }
+            if (slot && slot->address)
+            {
+                slot->address = 1;
+            }
+            continue;
+        }
+
+        if (!policy->growth)
+        {
+            wanted = event->new_capacity;
+        }
+        else if (event->add_length)
+        {
+            wanted = event->length + event->add_length <= capacity ? capacity : capacity + event->add_length + policy->growth(capacity);
+        }
+        else if (event->new_capacity < event->old_capacity)
+        {
+            wanted = event->requested; /* shrink */
+        }
+        else
+        {
+            wanted = event->requested > capacity ? event->requested : capacity;
+        }
+
+        if (wanted != capacity || !capacity)
+        {
+            replay_resize(backend, result, site, event->type_size, capacity, wanted);
+        }
+
+        if (slot && slot->address)
+        {
+            slot->address = 1;
+        }
+
+        slot = replay_find(event->moved);
+        slot->address = event->moved;
+        slot->capacity = wanted;
+    }
+}
+
+static int replay_read(const char *path)
+{
+    dyn_array_trace_header header;
+    FILE *file = fopen(path, "rb");
+    unsigned int i;
+    int ok;
+
+    if (!file)
+    {
+        return 0;
+    }
+
+    ok = fread(&header, sizeof(header), 1, file) == 1 &&
+         memcmp(header.magic, DYN_ARRAY_TRACE_MAGIC, sizeof(header.magic)) == 0 &&
+         header.version == DYN_ARRAY_TRACE_VERSION &&
+         header.endian == DYN_ARRAY_FILE_ENDIAN &&
+         header.event_size == sizeof(dyn_array_trace_event);
+
+    for (i = 0; ok && i < header.files; ++i)
+    {
+        unsigned int length;
+        char *name;
+
+        ok = fread(&length, sizeof(length), 1, file) == 1;
+        name = ok ? (char *)malloc(length + 1) : NULL;
+        ok = name && fread(name, 1, length, file) == length;
+
+        if (name)
+        {
+            name[ok ? length : 0] = 0;
+            dyn_array_add(files, name);
+        }
+    }
+
+    dyn_array_resize(events, (dyn_array_size)header.events);
+    ok = ok && fread(events, sizeof(dyn_array_trace_event), dyn_array_length(events), file) == dyn_array_length(events);
+
+    fclose(file);
+
+    if (ok)
+    {
+        fprintf(stderr, "%u events, %.0f dropped by the ring, %u files\n", (unsigned int)dyn_array_length(events), (double)header.dropped, header.files);
+    }
+
+    return ok;
+}
+
+static void replay_collect_sites(void)
+{
+    dyn_array_size e;
+    dyn_array_size s;
+    dyn_array_size capacity = 16;
+
+    while (capacity < 2 * dyn_array_length(events) + 2)
+    {
+        capacity *= 2;
+    }
+    dyn_array_resize(slots, capacity);
+    dyn_array_resize(event_sites, dyn_array_length(events));
+
+    for (e = 0; e < dyn_array_length(events); ++e)
+    {
+        for (s = 0; s < dyn_array_length(sites); ++s)
+        {
+            if (sites[s].file == events[e].file && sites[s].line == events[e].line)
+            {
+                break;
+            }
+        }
+
+        if (s == dyn_array_length(sites))
+        {
+            replay_site site = {0, 0, 0, 0, 0};
+            site.file = events[e].file;
+            site.line = events[e].line;
+            dyn_array_add(sites, site);
+        }
+
+        event_sites[e] = s;
+    }
+}
+
+static int replay_string_equals(const char *a, const char *b)
+{
+    while (*a && *a == *b)
+    {
+        ++a;
+        ++b;
+    }
+
+    return *a == *b;
+}
+
+int main(int argc, char **argv)
+{
+    replay_result result;
+    int per_site = argc > 2 && replay_string_equals(argv[2], "--sites");
+    unsigned int p;
+    unsigned int b;
+    dyn_array_size s;
+
+    if (argc < 2 || !replay_read(argv[1]))
+    {
+        fprintf(stderr, "usage: dyn_array_replay trace.bin [--sites]\n");
+        return 1;
+    }
+
+    replay_collect_sites();
+
+    printf("policy,backend,reallocs,alloc_bytes,copied_bytes,peak_bytes\n");
+
+    for (p = 0; p < sizeof(replay_policies) / sizeof(replay_policies[0]); ++p)
+    {
+        for (b = 0; b < sizeof(replay_backends) / sizeof(replay_backends[0]); ++b)
+        {
+            replay_run(&replay_policies[p], &replay_backends[b], &result);
+            printf("%s,%s,%.0f,%.0f,%.0f,%.0f\n", replay_policies[p].name, replay_backends[b].name,
+                   (double)result.reallocs, (double)result.alloc_bytes, (double)result.copied_bytes, (double)result.peak_bytes);
+        }
+    }
+
+    if (!per_site)
+    {
+        return 0;
+    }
+
+    printf("\nsite,policy,backend,reallocs,alloc_bytes,copied_bytes\n");
+
+    for (p = 0; p < sizeof(replay_policies) / sizeof(replay_policies[0]); ++p)
+    {
+        for (b = 0; b < sizeof(replay_backends) / sizeof(replay_backends[0]); ++b)
+        {
+            for (s = 0; s < dyn_array_length(sites); ++s)
+            {
+                sites[s].reallocs = sites[s].alloc_bytes = sites[s].copied_bytes = 0;
+            }
+
+            replay_run(&replay_policies[p], &replay_backends[b], &result);
+
+            for (s = 0; s < dyn_array_length(sites); ++s)
+            {
+                printf("%s:%u,%s,%s,%.0f,%.0f,%.0f\n", sites[s].file < dyn_array_length(files) ? files[sites[s].file] : "dyn_array.h", sites[s].line,
+                       replay_policies[p].name, replay_backends[b].name,
+                       (double)sites[s].reallocs, (double)sites[s].alloc_bytes, (double)sites[s].copied_bytes);
+            }
+        }
+    }
+
+    return 0;
+}
+
+/*
+   ------------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+*/
@@ -11,6 +11,35 @@ LICENSE
 
 */
 #define DYN_ARRAY_COLLECT_STATISTICS
+#define DYN_ARRAY_PARALLEL
+#define DYN_ARRAY_CONCURRENT
+#define DYN_ARRAY_FILE
+#define DYN_ARRAY_TRACE
+#define DYN_ARRAY_TRACE_EVENTS 16384
+#define DYN_ARRAY_VIRTUAL_MEMORY
+#define DYN_ARRAY_VM_RESERVE_SIZE ((dyn_array_usize)1024 * 1024)
+#define DYN_ARRAY_SEGMENTED_BLOCK_BYTES 256
+#ifdef __linux__
+#define DYN_ARRAY_MREMAP
+#endif
+
+#include <stdlib.h>
+
+/* Fails the n-th following allocation (0 never) to cover the out of memory paths */
+static unsigned int dyn_array_test_fail_allocation;
+
+static void *dyn_array_test_realloc(void *pointer, size_t size)
+{
+    if (dyn_array_test_fail_allocation && --dyn_array_test_fail_allocation == 0)
+    {
+        return NULL;
+    }
+
+    return realloc(pointer, size);
+}
+
+#define DYN_ARRAY_FUNCTION_REALLOC(p, s) (dyn_array_test_realloc(p, s))
+#define DYN_ARRAY_FUNCTION_FREE(p) (free(p))
 #include "../dyn_array.h"
 
 #include "test.h" /* Simple Testing framework */
@@ -44,7 +73,8 @@ void dyn_array_test_simple_type(void)
     assert(dyn_array_length(myNumbers) == 3);
     assert(dyn_array_last(myNumbers) == 3.0);
 
-    dyn_array_del(myNumbers);
+    /* Evaluates to the length before the delete, with and without DYN_ARRAY_AUTO_SHRINK */
+    assert(dyn_array_del(myNumbers) == 3);
 
     assert(dyn_array_capacity(myNumbers) == 4);
     assert(dyn_array_length(myNumbers) == 2);
@@ -62,7 +92,7 @@ void dyn_array_test_simple_type(void)
     assert(dyn_array_length(myNumbers) == 0);
 
     /* length is already 0. check if calling delete will not decrease the length further */
-    dyn_array_del(myNumbers);
+    assert(dyn_array_del(myNumbers) == 0);
 
     assert(dyn_array_length(myNumbers) == 0);
 
@@ -193,6 +223,2031 @@ void dyn_array_test_add_array(void)
     assert(dyn_array_stats_init - dyn_array_stats_free == 0);
 }
 
+void dyn_array_test_add_array_bulk(void)
+{
+    unsigned int i;
+    unsigned int offset;
+    unsigned char *bytes = NULL;
+    unsigned char source[64];
+    point *myPoints = NULL;
+    point points[3] = {{1, 2}, {3, 4}, {5, 6}};
+
+    dyn_array_stats_reset();
+
+    for (i = 0; i < 64; ++i)
+    {
+        source[i] = (unsigned char)i;
+    }
+
+    /* Append from every source/destination misalignment to exercise the head, word and tail copy loops */
+    for (offset = 0; offset < 9; ++offset)
+    {
+        dyn_array_add_array(bytes, source + offset, 64 - offset);
+    }
+
+    assert(dyn_array_length(bytes) == 540);
+
+    for (offset = 0, i = 0; offset < 9; ++offset)
+    {
+        unsigned int j;
+
+        for (j = offset; j < 64 && bytes[i] == (unsigned char)j; ++j, ++i)
+        {
+        }
+    }
+
+    assert(i == 540);
+
+    dyn_array_add(myPoints, points[0]);
+    dyn_array_add_array(myPoints, points, 3);
+
+    assert(dyn_array_length(myPoints) == 4);
+    assert(myPoints[0].x == 1 && myPoints[1].x == 1 && myPoints[2].x == 3 && myPoints[3].y == 6);
+
+    /* Appending zero elements keeps the content untouched */
+    dyn_array_add_array(myPoints, points, 0);
+
+    assert(dyn_array_length(myPoints) == 4);
+
+    dyn_array_free(bytes);
+    dyn_array_free(myPoints);
+
+    assert(dyn_array_stats_init - dyn_array_stats_free == 0);
+}
+
+void dyn_array_test_virtual_memory(void)
+{
+    unsigned int i;
+    unsigned int *numbers;
+    unsigned int *moved;
+    dyn_array_usize count = 4096;
+
+    numbers = (unsigned int *)dyn_array_vm_realloc(DYN_ARRAY_NULL, count * sizeof(unsigned int));
+
+    assert(numbers != NULL);
+
+    for (i = 0; i < count; ++i)
+    {
+        numbers[i] = i;
+    }
+
+    /* Grow inside the reserved range: pages are committed in place and the pointer stays the same */
+    count = 128 * 1024;
+    assert(dyn_array_vm_realloc(numbers, count * sizeof(unsigned int)) == numbers);
+
+    for (i = 4096; i < count; ++i)
+    {
+        numbers[i] = i;
+    }
+
+    /* Shrinking keeps the committed pages */
+    assert(dyn_array_vm_realloc(numbers, 16) == numbers);
+
+    /* Exceeding the 1MB reservation of this test moves the array once into a bigger reservation */
+    moved = (unsigned int *)dyn_array_vm_realloc(numbers, 2 * DYN_ARRAY_VM_RESERVE_SIZE);
+
+    assert(moved != NULL);
+    assert(moved != numbers);
+
+    for (i = 0; i < count && moved[i] == i; ++i)
+    {
+    }
+
+    assert(i == count);
+
+    dyn_array_vm_free(moved);
+}
+
+#ifdef DYN_ARRAY_MREMAP
+void dyn_array_test_mremap(void)
+{
+    unsigned int i;
+    unsigned int count;
+    unsigned int *numbers = NULL;
+    unsigned int *grown;
+
+    /* Small blocks are served from the heap */
+    count = 1024;
+    numbers = (unsigned int *)dyn_array_mremap_realloc(numbers, count * sizeof(unsigned int));
+
+    assert(numbers != NULL);
+    assert(((dyn_array_mremap_block *)numbers - 1)->mapped == 0);
+
+    for (i = 0; i < count; ++i)
+    {
+        numbers[i] = i;
+    }
+
+    /* Crossing the threshold moves the block into a mapping */
+    count = 256 * 1024;
+    numbers = (unsigned int *)dyn_array_mremap_realloc(numbers, count * sizeof(unsigned int));
+
+    assert(numbers != NULL);
+    assert(((dyn_array_mremap_block *)numbers - 1)->mapped >= count * sizeof(unsigned int));
+
+    for (i = 1024; i < count; ++i)
+    {
+        numbers[i] = i;
+    }
+
+    /* Mapped blocks grow with mremap and keep their content */
+    grown = (unsigned int *)dyn_array_mremap_realloc(numbers, 4 * count * sizeof(unsigned int));
+
+    assert(grown != NULL);
+
+    for (i = 0; i < count && grown[i] == i; ++i)
+    {
+    }
+
+    assert(i == count);
+
+    /* Shrinking a mapped block keeps the mapping */
+    assert(dyn_array_mremap_realloc(grown, 16) == grown);
+
+    dyn_array_mremap_free(grown);
+}
+#endif
+
+void dyn_array_test_grow_policies(void)
+{
+    unsigned int c = 1000;
+    dyn_array_usize b = 100;
+
+    /* The default policy keeps the 1.5x growth of the floating point version */
+    assert(DYN_ARRAY_GROW_FACTOR_FUNCTION(c) == 500);
+    assert(DYN_ARRAY_GROW_FACTOR_1_5X(3u) == 1);
+    assert(DYN_ARRAY_GROW_FACTOR_2X(c) == 1000);
+    assert(DYN_ARRAY_GROW_FACTOR_GOLDEN(c) == 618);
+
+    /* malloc chunks grow in 16 byte steps and carry 8 bytes of chunk header */
+    assert(DYN_ARRAY_GROW_ROUND_MALLOC(b) == 104);
+    assert(DYN_ARRAY_GROW_ROUND_MALLOC((dyn_array_usize)104) == 104);
+    assert(DYN_ARRAY_GROW_ROUND_PAGE(b) == 4096);
+    assert(DYN_ARRAY_GROW_ROUND_SIZE_CLASS(b) == 104);
+    assert(DYN_ARRAY_GROW_ROUND_SIZE_CLASS((dyn_array_usize)5000) == 8192);
+}
+
+void dyn_array_test_size_overflow(void)
+{
+    double *numbers = NULL;
+
+    dyn_array_stats_reset();
+
+    /* Byte sizes which do not fit into dyn_array_usize fail instead of wrapping around */
+    assert(dyn_array_grow_function(DYN_ARRAY_NULL, DYN_ARRAY_USIZE_MAX / 2, 4, 0) == NULL);
+
+    dyn_array_init(numbers, 2);
+
+    /* Capacities which do not fit into dyn_array_size fail instead of wrapping around */
+    assert(dyn_array_grow_function(numbers, sizeof *numbers, dyn_array_capacity(numbers), DYN_ARRAY_SIZE_MAX) == NULL);
+    assert(dyn_array_capacity(numbers) == 2);
+
+    dyn_array_free(numbers);
+
+    assert(dyn_array_stats_realloc == 1);
+    assert(dyn_array_stats_init - dyn_array_stats_free == 0);
+}
+
+void dyn_array_test_header_layout(void)
+{
+    unsigned int i;
+    unsigned char *bytes = NULL;
+    float *numbers = NULL;
+
+#if defined(DYN_ARRAY_HEADER_COMPACT) && !defined(DYN_ARRAY_ALIGNMENT)
+    assert(sizeof(dyn_array_header) == 2 * sizeof(dyn_array_size));
+#endif
+
+    /* Grow through many reallocations: element 0 stays aligned and the content survives every move */
+    for (i = 0; i < 10000; ++i)
+    {
+        dyn_array_add(numbers, (float)i);
+        dyn_array_add(bytes, (unsigned char)i);
+
+#ifdef DYN_ARRAY_ALIGNMENT
+        if (((dyn_array_usize)numbers & (DYN_ARRAY_ALIGNMENT - 1)) || ((dyn_array_usize)bytes & (DYN_ARRAY_ALIGNMENT - 1)))
+        {
+            break;
+        }
+#elif !defined(DYN_ARRAY_HEADER_COMPACT)
+        /* The header keeps the alignment of malloc (16 bytes on 64-bit) for element 0 */
+        if (((dyn_array_usize)numbers % (2 * sizeof(void *))) || ((dyn_array_usize)bytes % (2 * sizeof(void *))))
+        {
+            break;
+        }
+#endif
+    }
+
+    assert(i == 10000);
+
+    for (i = 0; i < 10000 && numbers[i] == (float)i && bytes[i] == (unsigned char)i; ++i)
+    {
+    }
+
+    assert(i == 10000);
+
+    /* Shrinking below the length keeps the leading elements */
+    dyn_array_init(numbers, 16);
+
+    assert(dyn_array_capacity(numbers) == 16);
+    assert(numbers[15] == 15.0f);
+
+    dyn_array_free(numbers);
+    dyn_array_free(bytes);
+}
+
+void dyn_array_test_memory_move(void)
+{
+    unsigned int i;
+    unsigned char buffer[64];
+
+    for (i = 0; i < 64; ++i)
+    {
+        buffer[i] = (unsigned char)i;
+    }
+
+    /* Overlapping move towards the end copies backwards */
+    dyn_array_memory_move(buffer + 3, buffer, 48);
+
+    for (i = 0; i < 48 && buffer[3 + i] == (unsigned char)i; ++i)
+    {
+    }
+
+    assert(i == 48);
+
+    /* Overlapping move towards the start copies forwards */
+    dyn_array_memory_move(buffer, buffer + 3, 48);
+
+    for (i = 0; i < 48 && buffer[i] == (unsigned char)i; ++i)
+    {
+    }
+
+    assert(i == 48);
+}
+
+void dyn_array_test_capacity_management(void)
+{
+    unsigned int i;
+    int *numbers = NULL;
+
+    /* reserve allocates at least length + n, exactly n for a new array, and does not touch the length */
+    dyn_array_reserve(numbers, 10);
+
+    assert(numbers != NULL);
+    assert(dyn_array_capacity(numbers) == 10);
+    assert(dyn_array_length(numbers) == 0);
+
+    dyn_array_add(numbers, 1);
+    dyn_array_reserve(numbers, 5);
+    assert(dyn_array_capacity(numbers) == 10);
+
+    /* Growing applies the growth factor like dyn_array_add */
+    dyn_array_reserve(numbers, 20);
+    assert(dyn_array_capacity(numbers) == 21 + (dyn_array_size)DYN_ARRAY_GROW_FACTOR_FUNCTION(10));
+    assert(numbers[0] == 1);
+
+    /* A reserve before every add reallocates only O(log n) times */
+    dyn_array_stats_reset();
+
+    for (i = 0; i < 10000; ++i)
+    {
+        dyn_array_reserve(numbers, 1);
+        dyn_array_add_unchecked(numbers, (int)i);
+    }
+
+    assert(dyn_array_stats_realloc < 32);
+    assert(numbers[10000] == 9999);
+
+    /* resize_zero zeroes the new tail */
+    dyn_array_resize(numbers, 8);
+    assert(dyn_array_length(numbers) == 8);
+
+    for (i = 0; i < 8; ++i)
+    {
+        numbers[i] = -1;
+    }
+
+    dyn_array_resize(numbers, 4);
+    assert(dyn_array_length(numbers) == 4);
+
+    dyn_array_resize_zero(numbers, 100);
+    assert(dyn_array_length(numbers) == 100);
+    assert(dyn_array_capacity(numbers) >= 100);
+
+    for (i = 4; i < 100 && numbers[i] == 0; ++i)
+    {
+    }
+
+    assert(i == 100);
+    assert(numbers[3] == -1);
+
+    /* clear keeps the storage */
+    dyn_array_clear(numbers);
+    assert(dyn_array_length(numbers) == 0);
+    assert(dyn_array_capacity(numbers) >= 100);
+
+    dyn_array_resize(numbers, 2);
+    numbers[0] = 7;
+    numbers[1] = 8;
+    dyn_array_shrink_to_fit(numbers);
+    assert(dyn_array_capacity(numbers) == 2);
+    assert(numbers[0] == 7 && numbers[1] == 8);
+
+    dyn_array_free(numbers);
+
+    /* All functions are valid on a NULL array */
+    dyn_array_clear(numbers);
+    dyn_array_shrink_to_fit(numbers);
+    assert(numbers == NULL);
+
+    dyn_array_resize_zero(numbers, 3);
+    assert(dyn_array_length(numbers) == 3);
+    assert(numbers[0] == 0 && numbers[1] == 0 && numbers[2] == 0);
+
+    dyn_array_free(numbers);
+}
+
+#ifdef DYN_ARRAY_AUTO_SHRINK
+void dyn_array_test_auto_shrink(void)
+{
+    unsigned int i;
+    unsigned int capacity;
+    int *numbers = NULL;
+
+    dyn_array_resize(numbers, 100000);
+    capacity = dyn_array_capacity(numbers);
+
+    /* Deleting down to a quarter of the capacity shrinks to twice the length */
+    while (dyn_array_length(numbers) >= capacity / DYN_ARRAY_SHRINK_DIVISOR)
+    {
+        dyn_array_del(numbers);
+    }
+
+    assert(dyn_array_capacity(numbers) == dyn_array_length(numbers) * 2);
+
+    /* Oscillating around the new length does not realloc */
+    capacity = dyn_array_capacity(numbers);
+
+    for (i = 0; i < 1000; ++i)
+    {
+        dyn_array_add(numbers, 1);
+        dyn_array_del(numbers);
+    }
+
+    assert(dyn_array_capacity(numbers) == capacity);
+
+    /* Small arrays never shrink below DYN_ARRAY_SHRINK_MIN_BYTES */
+    dyn_array_resize(numbers, 0);
+    assert(dyn_array_capacity(numbers) == DYN_ARRAY_SHRINK_MIN_BYTES / sizeof(int));
+
+    /* Swap remove shrinks like dyn_array_del */
+    dyn_array_resize(numbers, 100000);
+    capacity = dyn_array_capacity(numbers);
+
+    while (dyn_array_length(numbers) >= capacity / DYN_ARRAY_SHRINK_DIVISOR)
+    {
+        dyn_array_swap_remove(numbers, 0);
+    }
+
+    assert(dyn_array_capacity(numbers) == dyn_array_length(numbers) * 2);
+
+    dyn_array_free(numbers);
+}
+#endif
+
+/* Simulates read(): writes at most "count" bytes and returns how many were written */
+static unsigned int dyn_array_test_produce(unsigned char *destination, unsigned int count, unsigned int *produced)
+{
+    unsigned int i;
+    unsigned int written = count > 100 ? 100 : count;
+
+    for (i = 0; i < written; ++i)
+    {
+        destination[i] = (unsigned char)(*produced + i);
+    }
+
+    *produced += written;
+
+    return written;
+}
+
+void dyn_array_test_add_uninitialized(void)
+{
+    unsigned int i;
+    unsigned int produced = 0;
+    unsigned char *bytes = NULL;
+    unsigned char *tail;
+
+    for (i = 0; i < 50; ++i)
+    {
+        tail = dyn_array_add_uninitialized(bytes, 256);
+
+        if (tail != bytes + dyn_array_length(bytes) || dyn_array_capacity(bytes) - dyn_array_length(bytes) < 256)
+        {
+            break;
+        }
+
+        dyn_array_add_commit(bytes, dyn_array_test_produce(tail, 256, &produced));
+    }
+
+    assert(i == 50);
+    assert(dyn_array_length(bytes) == 5000);
+
+    for (i = 0; i < 5000 && bytes[i] == (unsigned char)i; ++i)
+    {
+    }
+
+    assert(i == 5000);
+
+    /* Space already available does not realloc and a zero commit keeps the length */
+    tail = dyn_array_add_uninitialized(bytes, 1);
+    dyn_array_add_commit(bytes, 0);
+    assert(dyn_array_length(bytes) == 5000);
+    assert(tail == bytes + 5000);
+
+    dyn_array_free(bytes);
+}
+
+void dyn_array_test_insert_erase(void)
+{
+    unsigned int i;
+    int *numbers = NULL;
+    int block[3] = {100, 101, 102};
+
+    for (i = 0; i < 10; ++i)
+    {
+        dyn_array_add(numbers, (int)i);
+    }
+
+    /* Insert at the front, in the middle and at the end */
+    dyn_array_insert(numbers, 0, -1);
+    dyn_array_insert(numbers, 5, -5);
+    dyn_array_insert(numbers, dyn_array_length(numbers), -10);
+
+    assert(dyn_array_length(numbers) == 13);
+    assert(numbers[0] == -1);
+    assert(numbers[1] == 0);
+    assert(numbers[5] == -5);
+    assert(numbers[6] == 4);
+    assert(numbers[11] == 9);
+    assert(numbers[12] == -10);
+
+    /* The value is read before the tail moves, even if it is an element of the array */
+    dyn_array_insert(numbers, 0, numbers[0]);
+    assert(numbers[0] == -1 && numbers[1] == -1 && numbers[2] == 0);
+    dyn_array_erase(numbers, 0);
+
+    /* One spare slot is enough, e.g. after a reserve of one */
+    dyn_array_reserve(numbers, 1);
+    i = (unsigned int)dyn_array_capacity(numbers);
+    while (dyn_array_length(numbers) + 1 < dyn_array_capacity(numbers))
+    {
+        dyn_array_add(numbers, 0);
+    }
+    dyn_array_insert(numbers, 1, 7);
+    assert(dyn_array_capacity(numbers) == i);
+    assert(numbers[0] == -1 && numbers[1] == 7 && numbers[2] == 0);
+    assert(dyn_array_length(numbers) == i);
+    dyn_array_erase(numbers, 1);
+    dyn_array_resize(numbers, 13);
+
+    /* Indices beyond the length are ignored */
+    dyn_array_insert(numbers, 14, -14);
+    dyn_array_insert_array(numbers, 14, block, 3);
+    assert(dyn_array_length(numbers) == 13);
+
+    /* Undo the inserts */
+    dyn_array_erase(numbers, 12);
+    dyn_array_erase(numbers, 5);
+    dyn_array_erase(numbers, 0);
+
+    assert(dyn_array_length(numbers) == 10);
+
+    for (i = 0; i < 10 && numbers[i] == (int)i; ++i)
+    {
+    }
+
+    assert(i == 10);
+
+    /* Range operations shift the tail once */
+    dyn_array_insert_array(numbers, 2, block, 3);
+
+    assert(dyn_array_length(numbers) == 13);
+    assert(numbers[1] == 1);
+    assert(numbers[2] == 100 && numbers[3] == 101 && numbers[4] == 102);
+    assert(numbers[5] == 2);
+    assert(numbers[12] == 9);
+
+    dyn_array_erase_range(numbers, 2, 3);
+    assert(dyn_array_length(numbers) == 10);
+    assert(numbers[2] == 2);
+
+    dyn_array_erase_range(numbers, 7, 3);
+    assert(dyn_array_length(numbers) == 7);
+    assert(numbers[6] == 6);
+
+    dyn_array_erase_range(numbers, 0, 0);
+    assert(dyn_array_length(numbers) == 7);
+
+    /* Swap remove replaces the element with the last one */
+    dyn_array_swap_remove(numbers, 1);
+    assert(dyn_array_length(numbers) == 6);
+    assert(numbers[1] == 6);
+
+    dyn_array_swap_remove(numbers, 5);
+    assert(dyn_array_length(numbers) == 5);
+    assert(numbers[4] == 4);
+
+    /* Indices beyond the length are ignored */
+    dyn_array_swap_remove(numbers, 5);
+    dyn_array_erase_range(numbers, 4, 2);
+    assert(dyn_array_length(numbers) == 5);
+    assert(numbers[4] == 4);
+
+    dyn_array_free(numbers);
+    dyn_array_swap_remove(numbers, 0);
+    assert(!numbers);
+}
+
+static int dyn_array_test_compare_int(const void *a, const void *b)
+{
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+
+    return (x > y) - (x < y);
+}
+
+static int dyn_array_test_compare_point(const void *a, const void *b)
+{
+    const point *p = (const point *)a;
+    const point *q = (const point *)b;
+
+    return p->x != q->x ? (p->x > q->x) - (p->x < q->x) : (p->y > q->y) - (p->y < q->y);
+}
+
+/* Deterministic pseudo random numbers (LCG) */
+static unsigned int dyn_array_test_random(unsigned int *state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+void dyn_array_test_sort(void)
+{
+    unsigned int i;
+    unsigned int state = 42;
+    int *numbers = NULL;
+    point *points = NULL;
+
+    /* Random input with many duplicates */
+    for (i = 0; i < 10000; ++i)
+    {
+        dyn_array_add(numbers, (int)(dyn_array_test_random(&state) % 1000) - 500);
+    }
+
+    dyn_array_sort(numbers, dyn_array_test_compare_int);
+
+    for (i = 1; i < 10000 && numbers[i - 1] <= numbers[i]; ++i)
+    {
+    }
+
+    assert(i == 10000);
+
+    /* Already sorted and reversed input */
+    for (i = 0; i < 10000; ++i)
+    {
+        numbers[i] = (int)(10000 - i);
+    }
+
+    dyn_array_sort(numbers, dyn_array_test_compare_int);
+    dyn_array_sort(numbers, dyn_array_test_compare_int);
+
+    for (i = 0; i < 10000 && numbers[i] == (int)(i + 1); ++i)
+    {
+    }
+
+    assert(i == 10000);
+
+    /* The heapsort fallback of the introsort on its own */
+    for (i = 0; i < 10000; ++i)
+    {
+        numbers[i] = (int)(dyn_array_test_random(&state) % 100);
+    }
+
+    dyn_array_sort_heap((char *)numbers, 10000, sizeof(int), dyn_array_test_compare_int);
+
+    for (i = 1; i < 10000 && numbers[i - 1] <= numbers[i]; ++i)
+    {
+    }
+
+    assert(i == 10000);
+
+    /* Struct elements with a two field comparator */
+    for (i = 0; i < 1000; ++i)
+    {
+        point p;
+        p.x = (int)(dyn_array_test_random(&state) % 10);
+        p.y = (int)(dyn_array_test_random(&state) % 100);
+        dyn_array_add(points, p);
+    }
+
+    dyn_array_sort(points, dyn_array_test_compare_point);
+
+    for (i = 1; i < 1000 && dyn_array_test_compare_point(&points[i - 1], &points[i]) <= 0; ++i)
+    {
+    }
+
+    assert(i == 1000);
+
+    /* Empty and NULL arrays */
+    dyn_array_free(numbers);
+    dyn_array_sort(numbers, dyn_array_test_compare_int);
+    assert(numbers == NULL);
+
+    dyn_array_free(points);
+}
+
+void dyn_array_test_radix_sort(void)
+{
+    unsigned int i;
+    unsigned int state = 7;
+    int *numbers = NULL;
+    int *numbers_scratch = NULL;
+    double *reals = NULL;
+    double *reals_scratch = NULL;
+    point *points = NULL;
+    point *points_scratch = NULL;
+#ifndef DYN_ARRAY_HEADER_COMPACT
+    dyn_array_usize storage[DYN_ARRAY_BUFFER_WORDS(int, 4)];
+#endif
+
+    /* Signed integers including negative values */
+    for (i = 0; i < 10000; ++i)
+    {
+        dyn_array_add(numbers, (int)dyn_array_test_random(&state) - (1 << 23));
+    }
+
+    dyn_array_radix_sort(numbers, numbers_scratch, DYN_ARRAY_KEY_SIGNED);
+
+    assert(dyn_array_length(numbers) == 10000);
+
+    for (i = 1; i < 10000 && numbers[i - 1] <= numbers[i]; ++i)
+    {
+    }
+
+    assert(i == 10000);
+
+    /* IEEE doubles with both signs */
+    for (i = 0; i < 10000; ++i)
+    {
+        dyn_array_add(reals, ((double)dyn_array_test_random(&state) - 8388608.0) / 1000.0);
+    }
+
+    dyn_array_add(reals, -0.0);
+    dyn_array_add(reals, 1e300);
+    dyn_array_add(reals, -1e300);
+
+    dyn_array_radix_sort(reals, reals_scratch, DYN_ARRAY_KEY_FLOAT);
+
+    assert(reals[0] == -1e300);
+    assert(reals[10002] == 1e300);
+
+    for (i = 1; i < 10003 && reals[i - 1] <= reals[i]; ++i)
+    {
+    }
+
+    assert(i == 10003);
+
+    /* Keyed by a member of a struct: the sort is stable, so sorting by y then by x orders by (x, y) */
+    for (i = 0; i < 1000; ++i)
+    {
+        point p;
+        p.x = (int)(dyn_array_test_random(&state) % 10);
+        p.y = (int)(dyn_array_test_random(&state) % 100);
+        dyn_array_add(points, p);
+    }
+
+    dyn_array_radix_sort_key(points, points_scratch, (char *)&points[0].y - (char *)&points[0], sizeof(int), DYN_ARRAY_KEY_UNSIGNED);
+    dyn_array_radix_sort_key(points, points_scratch, (char *)&points[0].x - (char *)&points[0], sizeof(int), DYN_ARRAY_KEY_UNSIGNED);
+
+    for (i = 1; i < 1000 && dyn_array_test_compare_point(&points[i - 1], &points[i]) <= 0; ++i)
+    {
+    }
+
+    assert(i == 1000);
+
+#ifndef DYN_ARRAY_HEADER_COMPACT
+    /* An array on a caller buffer is sorted in place: a single pass ends in the scratch array and is copied back */
+    {
+        int *in_buffer = NULL;
+        int *buffer_start;
+
+        dyn_array_init_buffer(in_buffer, storage, sizeof(storage));
+        buffer_start = in_buffer;
+        dyn_array_add(in_buffer, 3);
+        dyn_array_add(in_buffer, 1);
+        dyn_array_add(in_buffer, 2);
+
+        dyn_array_radix_sort(in_buffer, numbers_scratch, DYN_ARRAY_KEY_SIGNED);
+
+        assert(in_buffer == buffer_start);
+        assert(!dyn_array_owns_storage(in_buffer));
+        assert(dyn_array_owns_storage(numbers_scratch));
+        assert(in_buffer[0] == 1 && in_buffer[1] == 2 && in_buffer[2] == 3);
+
+        dyn_array_free(in_buffer);
+    }
+#endif
+
+    dyn_array_free(numbers);
+    dyn_array_free(numbers_scratch);
+    dyn_array_free(reals);
+    dyn_array_free(reals_scratch);
+    dyn_array_free(points);
+    dyn_array_free(points_scratch);
+}
+
+void dyn_array_test_sorted_arrays(void)
+{
+    unsigned int i;
+    int key;
+    int values_a[] = {1, 2, 2, 4, 7, 9};
+    int values_b[] = {2, 3, 4, 4, 9, 10};
+    int *a = NULL;
+    int *b = NULL;
+    int *output = NULL;
+    int *empty = NULL;
+
+    dyn_array_add_array(a, values_a, 6);
+    dyn_array_add_array(b, values_b, 6);
+
+    /* lower/upper bound on present, absent, duplicate and out of range keys */
+    key = 2;
+    assert(dyn_array_lower_bound(a, &key, dyn_array_test_compare_int) == 1);
+    assert(dyn_array_upper_bound(a, &key, dyn_array_test_compare_int) == 3);
+    key = 5;
+    assert(dyn_array_lower_bound(a, &key, dyn_array_test_compare_int) == 4);
+    assert(dyn_array_upper_bound(a, &key, dyn_array_test_compare_int) == 4);
+    key = 0;
+    assert(dyn_array_lower_bound(a, &key, dyn_array_test_compare_int) == 0);
+    key = 100;
+    assert(dyn_array_lower_bound(a, &key, dyn_array_test_compare_int) == 6);
+    assert(dyn_array_upper_bound(a, &key, dyn_array_test_compare_int) == 6);
+    assert(dyn_array_lower_bound(empty, &key, dyn_array_test_compare_int) == 0);
+
+    /* Every key of a larger array is found at its position */
+    for (i = 0; i < 1000; ++i)
+    {
+        dyn_array_add(output, (int)(i * 2));
+    }
+
+    for (i = 0; i < 2000; ++i)
+    {
+        key = (int)i;
+        if (dyn_array_lower_bound(output, &key, dyn_array_test_compare_int) != (i + 1) / 2)
+        {
+            break;
+        }
+    }
+
+    assert(i == 2000);
+    dyn_array_free(output);
+
+    /* Set operations */
+    dyn_array_merge(output, a, b, dyn_array_test_compare_int);
+    assert(dyn_array_length(output) == 12);
+    assert(dyn_array_capacity(output) == 12);
+    assert(output[0] == 1 && output[1] == 2 && output[3] == 2 && output[4] == 3 && output[11] == 10);
+    dyn_array_free(output);
+
+    dyn_array_union(output, a, b, dyn_array_test_compare_int);
+    assert(dyn_array_length(output) == 9); /* 1 2 2 3 4 4 7 9 10 */
+    assert(output[2] == 2 && output[3] == 3 && output[5] == 4 && output[8] == 10);
+    dyn_array_free(output);
+
+    dyn_array_intersection(output, a, b, dyn_array_test_compare_int);
+    assert(dyn_array_length(output) == 3); /* 2 4 9 */
+    assert(output[0] == 2 && output[1] == 4 && output[2] == 9);
+    dyn_array_free(output);
+
+    dyn_array_difference(output, a, b, dyn_array_test_compare_int);
+    assert(dyn_array_length(output) == 3); /* 1 2 7 */
+    assert(output[0] == 1 && output[1] == 2 && output[2] == 7);
+    dyn_array_free(output);
+
+    dyn_array_union(output, a, empty, dyn_array_test_compare_int);
+    assert(dyn_array_length(output) == 6);
+    dyn_array_free(output);
+
+    /* unique keeps the first element of every run */
+    dyn_array_add_array(a, values_b, 6);
+    dyn_array_sort(a, dyn_array_test_compare_int);
+    dyn_array_unique(a, dyn_array_test_compare_int);
+    assert(dyn_array_length(a) == 7); /* 1 2 3 4 7 9 10 */
+    assert(a[0] == 1 && a[1] == 2 && a[2] == 3 && a[3] == 4 && a[6] == 10);
+
+    dyn_array_free(a);
+    dyn_array_free(b);
+}
+
+void dyn_array_test_numeric(void)
+{
+    unsigned int i;
+    unsigned int state = 3;
+    unsigned int lengths[3] = {3, 64, 1003};
+    unsigned int l;
+
+    for (l = 0; l < 3; ++l)
+    {
+        unsigned int n = lengths[l];
+        float *floats = NULL;
+        double *doubles = NULL;
+        int *ints = NULL;
+        dyn_array_i64 *longs = NULL;
+        double float_sum = 0.0;
+        double double_sum = 0.0;
+        dyn_array_i64 int_sum = 0;
+        dyn_array_i64 int_dot = 0;
+        dyn_array_i64 long_sum = 0;
+        unsigned int int_min = 0;
+        unsigned int double_max = 0;
+        unsigned int sevens = 0;
+
+        for (i = 0; i < n; ++i)
+        {
+            int r = (int)(dyn_array_test_random(&state) % 2001) - 1000;
+
+            dyn_array_add(floats, (float)r * 0.5f);
+            dyn_array_add(doubles, (double)r * 0.25);
+            dyn_array_add(ints, r * 30000);
+            dyn_array_add(longs, (dyn_array_i64)r * 10000000000);
+
+            float_sum += (double)r * 0.5;
+            double_sum += (double)r * 0.25;
+            int_sum += (dyn_array_i64)r * 30000;
+            int_dot += (dyn_array_i64)r * 30000 * r * 30000;
+            long_sum += (dyn_array_i64)r * 10000000000;
+            int_min = ints[i] < ints[int_min] ? i : int_min;
+            double_max = doubles[i] > doubles[double_max] ? i : double_max;
+            sevens += r == 7;
+        }
+
+        /* Half and quarter integers are exact in float/double, so the sums are independent of the order */
+        assert(dyn_array_sum_float(floats) == (float)float_sum);
+        assert(dyn_array_sum_double(doubles) == double_sum);
+        assert(dyn_array_sum_int(ints) == int_sum);
+        assert(dyn_array_sum_int64(longs) == long_sum);
+        assert(dyn_array_dot_int(ints, ints) == int_dot);
+        assert(dyn_array_dot_double(doubles, doubles) == dyn_array_dot_double(doubles, doubles));
+
+        assert(dyn_array_argmin_int(ints) == int_min);
+        assert(dyn_array_min_int(ints) == ints[int_min]);
+        assert(dyn_array_argmax_double(doubles) == double_max);
+        assert(dyn_array_max_double(doubles) == doubles[double_max]);
+        assert(dyn_array_min_float(floats) == (float)ints[int_min] / 60000.0f);
+        assert(dyn_array_max_int64(longs) == (dyn_array_i64)(doubles[double_max] * 4.0) * 10000000000);
+
+        assert(dyn_array_count_int(ints, 210000) == sevens);
+        assert(dyn_array_count_float(floats, 3.5f) == sevens);
+        assert(dyn_array_find_int(ints, 150000) == dyn_array_find_int64(longs, (dyn_array_i64)50000000000));
+        assert(dyn_array_find_double(doubles, 1e9) == n);
+        assert(dyn_array_find_int(ints, ints[n - 1]) <= n - 1);
+
+        /* int sums are widened to 64-bit */
+        dyn_array_fill_int(ints, 2000000000);
+        assert(dyn_array_sum_int(ints) == (dyn_array_i64)2000000000 * n);
+        dyn_array_fill_int(ints, -2000000000);
+        assert(dyn_array_sum_int(ints) == (dyn_array_i64)-2000000000 * n);
+
+        /* fill and prefix sum */
+        dyn_array_fill_int(ints, 2);
+        dyn_array_prefix_sum_int(ints);
+        assert(ints[0] == 2);
+        assert(ints[n - 1] == (int)(2 * n));
+        assert(dyn_array_count_int(ints, 4) == 1);
+
+        dyn_array_fill_double(doubles, 0.5);
+        dyn_array_prefix_sum_double(doubles);
+        assert(doubles[n - 1] == 0.5 * (double)n);
+
+        dyn_array_free(floats);
+        dyn_array_free(doubles);
+        dyn_array_free(ints);
+        dyn_array_free(longs);
+    }
+}
+
+static int dyn_array_test_is_even(const void *element, void *context)
+{
+    (void)context;
+    return (*(const int *)element & 1) == 0;
+}
+
+static int dyn_array_test_point_below(const void *element, void *context)
+{
+    return ((const point *)element)->x < *(int *)context;
+}
+
+void dyn_array_test_filter(void)
+{
+    int *numbers = NULL;
+    int *scratch = NULL;
+    point *points = NULL;
+    unsigned char mask[32];
+    unsigned int i;
+    unsigned int mismatches = 0;
+    int limit = 5;
+    dyn_array_size matching;
+
+    /* filter keeps the matching elements in order */
+    for (i = 0; i < 100; ++i)
+    {
+        dyn_array_add(numbers, (int)i);
+    }
+
+    dyn_array_filter(numbers, dyn_array_test_is_even, NULL);
+    assert(dyn_array_length(numbers) == 50);
+
+    for (i = 0; i < 50; ++i)
+    {
+        mismatches += numbers[i] != (int)(i * 2);
+    }
+    assert(mismatches == 0);
+
+    /* remove_if drops them */
+    dyn_array_add(numbers, 7);
+    dyn_array_remove_if(numbers, dyn_array_test_is_even, NULL);
+    assert(dyn_array_length(numbers) == 1);
+    assert(numbers[0] == 7);
+
+    /* byte mask: keep every third element */
+    dyn_array_clear(numbers);
+    for (i = 0; i < 30; ++i)
+    {
+        dyn_array_add(numbers, (int)i);
+        mask[i] = (unsigned char)(i % 3 == 0);
+    }
+
+    dyn_array_filter_mask(numbers, mask);
+    assert(dyn_array_length(numbers) == 10);
+    assert(numbers[0] == 0);
+    assert(numbers[1] == 3);
+    assert(numbers[9] == 27);
+
+    /* bit mask (LSB first) with an empty byte and a partial last byte */
+    dyn_array_clear(numbers);
+    for (i = 0; i < 21; ++i)
+    {
+        dyn_array_add(numbers, (int)i);
+    }
+    mask[0] = 0x81; /* 0, 7 */
+    mask[1] = 0x00;
+    mask[2] = 0xF4; /* 18, 20 and bits beyond the length */
+
+    dyn_array_filter_bits(numbers, mask);
+    assert(dyn_array_length(numbers) == 4);
+    assert(numbers[0] == 0);
+    assert(numbers[1] == 7);
+    assert(numbers[2] == 18);
+    assert(numbers[3] == 20);
+
+    /* stable partition keeps the relative order of both groups */
+    dyn_array_clear(numbers);
+    for (i = 0; i < 10; ++i)
+    {
+        dyn_array_add(numbers, (int)(9 - i));
+    }
+
+    matching = dyn_array_partition_stable(numbers, scratch, dyn_array_test_is_even, NULL);
+    assert(matching == 5);
+    assert(dyn_array_length(numbers) == 10);
+    assert(numbers[0] == 8);
+    assert(numbers[4] == 0);
+    assert(numbers[5] == 9);
+    assert(numbers[9] == 1);
+
+    /* structs */
+    for (i = 0; i < 10; ++i)
+    {
+        point p;
+        p.x = (int)(i % 10);
+        p.y = (int)i;
+        dyn_array_add(points, p);
+    }
+
+    dyn_array_filter(points, dyn_array_test_point_below, &limit);
+    assert(dyn_array_length(points) == 5);
+    assert(points[4].x == 4);
+    assert(points[4].y == 4);
+
+    /* empty arrays */
+    dyn_array_clear(numbers);
+    dyn_array_filter(numbers, dyn_array_test_is_even, NULL);
+    assert(dyn_array_length(numbers) == 0);
+
+    dyn_array_free(numbers);
+    dyn_array_free(scratch);
+    dyn_array_free(points);
+}
+
+static void dyn_array_test_parallel_square(void *type, dyn_array_usize begin, dyn_array_usize end, void *context)
+{
+    int *numbers = (int *)type;
+    dyn_array_usize i;
+
+    (void)context;
+
+    for (i = begin; i < end; ++i)
+    {
+        numbers[i] = numbers[i] * numbers[i];
+    }
+}
+
+static void dyn_array_test_parallel_sum(const void *type, dyn_array_usize begin, dyn_array_usize end, void *partial, void *context)
+{
+    const int *numbers = (const int *)type;
+    dyn_array_i64 sum = *(dyn_array_i64 *)partial;
+    dyn_array_usize i;
+
+    (void)context;
+
+    for (i = begin; i < end; ++i)
+    {
+        sum += numbers[i];
+    }
+
+    *(dyn_array_i64 *)partial = sum;
+}
+
+static void dyn_array_test_parallel_add(void *output, const void *partial, void *context)
+{
+    (void)context;
+    *(dyn_array_i64 *)output += *(const dyn_array_i64 *)partial;
+}
+
+static void dyn_array_test_parallel_half(void *destination, const void *source, dyn_array_usize begin, dyn_array_usize end, void *context)
+{
+    double *halves = (double *)destination;
+    const int *numbers = (const int *)source;
+    dyn_array_usize i;
+
+    (void)context;
+
+    for (i = begin; i < end; ++i)
+    {
+        halves[i] = (double)numbers[i] * 0.5;
+    }
+}
+
+void dyn_array_test_parallel(void)
+{
+    dyn_array_parallel_pool *pool = dyn_array_parallel_create(4);
+    int *numbers = NULL;
+    double *halves = NULL;
+    dyn_array_i64 sum = 0;
+    dyn_array_i64 expected = 0;
+    unsigned int i;
+    unsigned int mismatches = 0;
+    unsigned int n = 100003;
+
+    assert(pool != NULL);
+    assert(pool->thread_count == 4);
+
+    for (i = 0; i < n; ++i)
+    {
+        dyn_array_add(numbers, (int)(i % 1000));
+        expected += (dyn_array_i64)(i % 1000) * (dyn_array_i64)(i % 1000);
+    }
+
+    /* small chunks so every worker claims many of them */
+    pool->grain = 97;
+
+    dyn_array_parallel_for(pool, numbers, dyn_array_test_parallel_square, NULL);
+
+    for (i = 0; i < n; ++i)
+    {
+        mismatches += numbers[i] != (int)((i % 1000) * (i % 1000));
+    }
+    assert(mismatches == 0);
+
+    dyn_array_parallel_reduce(pool, numbers, dyn_array_test_parallel_sum, dyn_array_test_parallel_add, &sum, NULL);
+    assert(sum == expected);
+
+    dyn_array_parallel_transform(pool, halves, numbers, dyn_array_test_parallel_half, NULL);
+    assert(dyn_array_length(halves) == n);
+
+    for (i = 0; i < n; ++i)
+    {
+        mismatches += halves[i] != (double)numbers[i] * 0.5;
+    }
+    assert(mismatches == 0);
+
+    /* automatic grain, the pool is reused across jobs */
+    pool->grain = 0;
+    sum = 0;
+    dyn_array_parallel_reduce(pool, numbers, dyn_array_test_parallel_sum, dyn_array_test_parallel_add, &sum, NULL);
+    assert(sum == expected);
+
+    /* without a pool everything runs on the calling thread */
+    sum = 0;
+    dyn_array_parallel_reduce((dyn_array_parallel_pool *)NULL, numbers, dyn_array_test_parallel_sum, dyn_array_test_parallel_add, &sum, NULL);
+    assert(sum == expected);
+
+    /* empty arrays */
+    dyn_array_clear(numbers);
+    sum = 0;
+    dyn_array_parallel_for(pool, numbers, dyn_array_test_parallel_square, NULL);
+    dyn_array_parallel_reduce(pool, numbers, dyn_array_test_parallel_sum, dyn_array_test_parallel_add, &sum, NULL);
+    assert(sum == 0);
+
+    dyn_array_parallel_destroy(pool);
+    dyn_array_free(numbers);
+    dyn_array_free(halves);
+}
+
+typedef struct dyn_array_test_producer
+{
+    dyn_array_concurrent *shared;
+    unsigned int id;
+
+} dyn_array_test_producer;
+
+#define DYN_ARRAY_TEST_PRODUCER_COUNT 20000
+
+static void *dyn_array_test_producer_run(void *argument)
+{
+    dyn_array_test_producer *producer = (dyn_array_test_producer *)argument;
+    unsigned int values[7];
+    unsigned int i = 0;
+    unsigned int j;
+
+    /* single adds mixed with batches that cross segment boundaries */
+    while (i < DYN_ARRAY_TEST_PRODUCER_COUNT)
+    {
+        if (i % 3 == 0 && i + 7 <= DYN_ARRAY_TEST_PRODUCER_COUNT)
+        {
+            for (j = 0; j < 7; ++j)
+            {
+                values[j] = producer->id * 100000 + i + j;
+            }
+            dyn_array_concurrent_add_array(producer->shared, values, 7);
+            i += 7;
+        }
+        else
+        {
+            values[0] = producer->id * 100000 + i;
+            dyn_array_concurrent_add(producer->shared, &values[0]);
+            i++;
+        }
+    }
+
+    return NULL;
+}
+
+void dyn_array_test_concurrent(void)
+{
+    dyn_array_concurrent shared;
+    dyn_array_test_producer producers[4];
+    DYN_ARRAY_THREAD threads[4];
+    unsigned int next[4] = {0, 0, 0, 0};
+    unsigned int *values = NULL;
+    unsigned int i;
+    unsigned int mismatches = 0;
+
+    dyn_array_concurrent_init(&shared, sizeof(unsigned int));
+
+    for (i = 0; i < 4; ++i)
+    {
+        producers[i].shared = &shared;
+        producers[i].id = i;
+        assert(DYN_ARRAY_THREAD_CREATE(threads[i], dyn_array_test_producer_run, &producers[i]));
+    }
+
+    for (i = 0; i < 4; ++i)
+    {
+        DYN_ARRAY_THREAD_JOIN(threads[i]);
+    }
+
+    assert(!shared.failed);
+    assert(dyn_array_concurrent_length(&shared) == 4 * DYN_ARRAY_TEST_PRODUCER_COUNT);
+    assert(*(unsigned int *)dyn_array_concurrent_at(&shared, 0) % 100000 == 0);
+
+    /* every value exactly once and each producer's values in the order it added them */
+    dyn_array_concurrent_to_array(&shared, values);
+    assert(dyn_array_length(values) == 4 * DYN_ARRAY_TEST_PRODUCER_COUNT);
+
+    for (i = 0; i < dyn_array_length(values); ++i)
+    {
+        unsigned int id = values[i] / 100000;
+        mismatches += id >= 4 || values[i] % 100000 != next[id];
+        next[id & 3]++;
+    }
+    assert(mismatches == 0);
+
+    dyn_array_concurrent_free(&shared);
+    assert(dyn_array_concurrent_length(&shared) == 0);
+    dyn_array_free(values);
+}
+
+void dyn_array_test_segmented(void)
+{
+    double **numbers = NULL;
+    point **points = NULL;
+    double *first;
+    double *block_first;
+    double sum = 0.0;
+    double expected = 0.0;
+    point p;
+    point batch[50];
+    dyn_array_usize b;
+    unsigned int i;
+    unsigned int mismatches = 0;
+
+    /* 256 byte blocks hold 32 doubles */
+    assert(dyn_array_segmented_block_size(numbers) == 32);
+    assert(dyn_array_segmented_length(numbers) == 0);
+    assert(dyn_array_segmented_capacity(numbers) == 0);
+
+    dyn_array_segmented_add(numbers, 0.0);
+    first = &dyn_array_segmented_at(numbers, 0);
+    assert(dyn_array_segmented_capacity(numbers) == 32);
+
+    for (i = 1; i < 1000; ++i)
+    {
+        dyn_array_segmented_add(numbers, (double)i);
+        expected += (double)i;
+    }
+
+    /* elements never move */
+    assert(&dyn_array_segmented_at(numbers, 0) == first);
+    assert(dyn_array_segmented_length(numbers) == 1000);
+    assert(dyn_array_segmented_capacity(numbers) == 1024);
+    assert(dyn_array_segmented_last(numbers) == 999.0);
+
+    for (i = 0; i < 1000; ++i)
+    {
+        mismatches += dyn_array_segmented_at(numbers, i) != (double)i;
+    }
+    assert(mismatches == 0);
+
+    /* chunk wise iteration */
+    assert(dyn_array_segmented_block_count(numbers) == 32);
+    assert(dyn_array_segmented_block_length(numbers, 31) == 8);
+
+    for (b = 0; b < dyn_array_segmented_block_count(numbers); ++b)
+    {
+        double *block = numbers[b];
+        dyn_array_usize n = dyn_array_segmented_block_length(numbers, b);
+
+        for (i = 0; i < n; ++i)
+        {
+            sum += block[i];
+        }
+    }
+    assert(sum == expected);
+
+    /* del and clear keep the blocks */
+    dyn_array_segmented_del(numbers);
+    assert(dyn_array_segmented_length(numbers) == 999);
+    assert(dyn_array_segmented_last(numbers) == 998.0);
+
+    block_first = numbers[0];
+    dyn_array_segmented_clear(numbers);
+    assert(dyn_array_segmented_length(numbers) == 0);
+    dyn_array_segmented_add(numbers, 7.0);
+    assert(numbers[0] == block_first);
+    assert(numbers[0][0] == 7.0);
+
+    dyn_array_segmented_free(numbers);
+    assert(numbers == NULL);
+
+    /* A failed block allocation releases the blocks of the same call and keeps the array */
+    dyn_array_segmented_add(numbers, 1.0);
+    dyn_array_test_fail_allocation = 3;
+    dyn_array_segmented_reserve(numbers, 100);
+    assert(dyn_array_test_fail_allocation == 0);
+    assert(dyn_array_segmented_capacity(numbers) == 32);
+    assert(dyn_array_segmented_length(numbers) == 1);
+    assert(numbers[0][0] == 1.0);
+
+    /* so does a failed table realloc */
+    dyn_array_test_fail_allocation = 1;
+    dyn_array_segmented_reserve(numbers, 200);
+    assert(dyn_array_segmented_capacity(numbers) == 32);
+
+    /* the add is dropped */
+    while (dyn_array_segmented_length(numbers) < 32)
+    {
+        dyn_array_segmented_add(numbers, 1.0);
+    }
+    dyn_array_test_fail_allocation = 1;
+    dyn_array_segmented_add(numbers, 2.0);
+    assert(dyn_array_segmented_length(numbers) == 32);
+    assert(dyn_array_segmented_last(numbers) == 1.0);
+    dyn_array_segmented_free(numbers);
+
+    /* a new array stays NULL */
+    dyn_array_test_fail_allocation = 2;
+    dyn_array_segmented_add(numbers, 1.0);
+    assert(numbers == NULL);
+
+    /* structs, reserve and bulk appends across block boundaries (256 / 8 = 32 points per block) */
+    dyn_array_segmented_reserve(points, 100);
+    assert(dyn_array_segmented_capacity(points) == 128);
+    assert(dyn_array_segmented_length(points) == 0);
+
+    p.x = -1;
+    p.y = -1;
+    dyn_array_segmented_add(points, p);
+
+    for (i = 0; i < 50; ++i)
+    {
+        batch[i].x = (int)i;
+        batch[i].y = (int)(i * 2);
+    }
+
+    dyn_array_segmented_add_array(points, batch, 50);
+    dyn_array_segmented_add_array(points, batch, 50);
+    assert(dyn_array_segmented_length(points) == 101);
+    assert(dyn_array_segmented_at(points, 0).x == -1);
+    assert(dyn_array_segmented_at(points, 32).x == 31);
+    assert(dyn_array_segmented_at(points, 51).y == 0);
+    assert(dyn_array_segmented_last(points).y == 98);
+
+    dyn_array_segmented_free(points);
+}
+
+#ifndef DYN_ARRAY_HEADER_COMPACT
+static unsigned int dyn_array_test_released;
+
+static void dyn_array_test_release(void *type, dyn_array_usize type_size)
+{
+    assert(type_size == sizeof(double));
+    assert(((double *)type)[0] == 3.0);
+    ++dyn_array_test_released;
+}
+
+void dyn_array_test_init_buffer(void)
+{
+    dyn_array_usize storage[DYN_ARRAY_BUFFER_WORDS(double, 4)];
+    dyn_array_usize tiny[1];
+    double *numbers = NULL;
+    double *in_buffer;
+    dyn_array_size capacity;
+    dyn_array_size i;
+
+    dyn_array_stats_reset();
+
+    dyn_array_init_buffer(numbers, storage, sizeof(storage));
+    assert(numbers != NULL);
+    assert(dyn_array_capacity(numbers) >= 4);
+    assert(dyn_array_length(numbers) == 0);
+    assert(!dyn_array_owns_storage(numbers));
+    assert((char *)numbers > (char *)storage);
+    assert((char *)(numbers + 4) <= (char *)storage + sizeof(storage));
+
+    /* no allocation while the buffer has room, shrinking keeps the buffer */
+    in_buffer = numbers;
+    capacity = dyn_array_capacity(numbers);
+    for (i = 0; i < capacity; ++i)
+    {
+        dyn_array_add(numbers, (double)i);
+    }
+    dyn_array_shrink_to_fit(numbers);
+    assert(numbers == in_buffer);
+    assert(dyn_array_stats_realloc == 0);
+
+    /* one more element moves the array into owned storage */
+    dyn_array_add(numbers, (double)capacity);
+    assert(numbers != in_buffer);
+    assert(dyn_array_owns_storage(numbers));
+    assert(dyn_array_stats_realloc == 1);
+    assert(dyn_array_length(numbers) == capacity + 1);
+    assert(numbers[0] == 0.0);
+    assert(numbers[capacity] == (double)capacity);
+
+    dyn_array_free(numbers);
+    assert(dyn_array_stats_free == 1);
+
+    /* freeing an array which never left the buffer does not touch the allocator */
+    dyn_array_init_buffer(numbers, storage, sizeof(storage));
+    dyn_array_add(numbers, 1.0);
+    dyn_array_free(numbers);
+    assert(!numbers);
+    assert(dyn_array_stats_free == 1);
+
+    /* resize and reserve beyond the buffer move as well */
+    dyn_array_init_buffer(numbers, storage, sizeof(storage));
+    dyn_array_add(numbers, 7.0);
+    dyn_array_reserve(numbers, 100);
+    assert(dyn_array_owns_storage(numbers));
+    assert(dyn_array_capacity(numbers) >= 101);
+    assert(numbers[0] == 7.0);
+    dyn_array_free(numbers);
+
+    /* not even the header fits */
+    dyn_array_init_buffer(numbers, tiny, 1);
+    assert(!numbers);
+    dyn_array_add(numbers, 1.0);
+    assert(dyn_array_owns_storage(numbers));
+    dyn_array_free(numbers);
+
+    /* dyn_array_free hands other storage back through its release function */
+    {
+        dyn_array_storage custom;
+
+        custom.grow = DYN_ARRAY_NULL;
+        custom.release = dyn_array_test_release;
+
+        dyn_array_stats_reset();
+        dyn_array_init_buffer(numbers, storage, sizeof(storage));
+        dyn_array_add(numbers, 3.0);
+        dyn_array_header(numbers)->data = &custom;
+        dyn_array_free(numbers);
+        assert(!numbers);
+        assert(dyn_array_test_released == 1);
+        assert(dyn_array_stats_free == 0);
+    }
+}
+#endif
+
+void dyn_array_test_deque(void)
+{
+    int *q = NULL;
+    int *first;
+    int *old;
+    int value;
+    int ordered;
+    dyn_array_size first_length;
+    dyn_array_size second_length;
+    dyn_array_size i;
+
+    dyn_array_stats_reset();
+
+    assert(dyn_array_deque_length(q) == 0);
+    assert(dyn_array_deque_first_span_length(q) == 0);
+
+    dyn_array_deque_push_back(q, 1);
+    dyn_array_deque_push_back(q, 2);
+    dyn_array_deque_push_front(q, 0);
+    assert(dyn_array_deque_length(q) == 3);
+    assert(dyn_array_deque_capacity(q) == 4);
+    assert(dyn_array_deque_front(q) == 0);
+    assert(dyn_array_deque_back(q) == 2);
+    assert(dyn_array_deque_at(q, 1) == 1);
+
+    /* push_front wrapped to the end of the buffer: two spans */
+    first_length = dyn_array_deque_first_span_length(q);
+    second_length = dyn_array_deque_second_span_length(q);
+    first = dyn_array_deque_first_span(q);
+    assert(first_length == 1);
+    assert(second_length == 2);
+    assert(first == q + 3);
+    assert(first[0] == 0 && q[0] == 1 && q[1] == 2);
+
+    /* growing a wrapped deque unwraps it */
+    old = q;
+    dyn_array_deque_push_front(q, -1);
+    dyn_array_deque_push_front(q, -2);
+    assert(q != old);
+    assert(dyn_array_deque_capacity(q) == 8);
+    assert(dyn_array_deque_length(q) == 5);
+    assert(dyn_array_stats_realloc == 2);
+    assert(dyn_array_stats_grow_with_factor == 1);
+
+    ordered = 1;
+    for (i = 0; i < dyn_array_deque_length(q); ++i)
+    {
+        ordered &= dyn_array_deque_at(q, i) == (int)i - 2;
+    }
+    assert(ordered);
+
+    value = dyn_array_deque_pop_front(q);
+    assert(value == -2);
+    value = dyn_array_deque_pop_back(q);
+    assert(value == 2);
+    assert(dyn_array_deque_length(q) == 3);
+
+    /* sliding window: no allocation while the length stays below the capacity */
+    for (i = 0; i < 1000; ++i)
+    {
+        dyn_array_deque_push_back(q, (int)i);
+        value = dyn_array_deque_pop_front(q);
+    }
+    assert(value == 996);
+    assert(dyn_array_deque_capacity(q) == 8);
+    assert(dyn_array_stats_realloc == 2);
+
+    first_length = dyn_array_deque_first_span_length(q);
+    second_length = dyn_array_deque_second_span_length(q);
+    assert(first_length + second_length == 3);
+
+    /* reserve and drain from both ends */
+    dyn_array_deque_reserve(q, 100);
+    assert(dyn_array_deque_capacity(q) == 128);
+    assert(dyn_array_deque_front(q) == 997);
+    assert(dyn_array_deque_back(q) == 999);
+
+    dyn_array_deque_clear(q);
+    for (i = 0; i < 100; ++i)
+    {
+        dyn_array_deque_push_front(q, (int)i);
+    }
+    ordered = 1;
+    for (i = 0; i < 50; ++i)
+    {
+        ordered &= dyn_array_deque_pop_back(q) == (int)i;
+        ordered &= dyn_array_deque_pop_front(q) == 99 - (int)i;
+    }
+    assert(ordered);
+    assert(dyn_array_deque_length(q) == 0);
+
+    /* Popping an empty deque keeps it empty */
+    (void)dyn_array_deque_pop_back(q);
+    (void)dyn_array_deque_pop_front(q);
+    assert(dyn_array_deque_length(q) == 0);
+
+    /* The pushed value may be an element of the deque, also when the push grows it */
+    dyn_array_deque_clear(q);
+    for (i = 0; i < 127; ++i)
+    {
+        dyn_array_deque_push_back(q, (int)i);
+    }
+    dyn_array_deque_push_front(q, dyn_array_deque_back(q));
+    assert(dyn_array_deque_capacity(q) == 128);
+    assert(dyn_array_deque_front(q) == 126);
+    dyn_array_deque_push_back(q, dyn_array_deque_at(q, 1));
+    assert(dyn_array_deque_capacity(q) == 256);
+    assert(dyn_array_deque_back(q) == 0);
+    dyn_array_deque_push_front(q, dyn_array_deque_at(q, 2));
+    assert(dyn_array_deque_front(q) == 1);
+    assert(dyn_array_deque_length(q) == 130);
+
+    dyn_array_deque_free(q);
+    assert(q == NULL);
+    assert(dyn_array_stats_free == 4);
+}
+
+#define TEST_PARTICLE_FIELDS(X) X(float, x) X(float, y) X(unsigned char, alive)
+DYN_ARRAY_SOA_DEFINE(test_particles, TEST_PARTICLE_FIELDS)
+
+void dyn_array_test_soa(void)
+{
+    test_particles particles;
+    float *x_before;
+    float sum = 0.0f;
+    int ok = 1;
+    int aligned;
+    dyn_array_size i;
+
+    dyn_array_stats_reset();
+
+    test_particles_init(&particles);
+    assert(particles.length == 0);
+    assert(particles.x == NULL);
+
+    for (i = 0; i < 100; ++i)
+    {
+        ok &= test_particles_add(&particles, (float)i, (float)(i * 2), (unsigned char)(i & 1));
+    }
+    assert(ok);
+    assert(particles.length == 100);
+    assert(particles.capacity == 128);
+
+    /* 16, 32, 64, 128 rows: one allocation per growth for all three columns */
+    assert(dyn_array_stats_realloc == 4);
+    assert(dyn_array_stats_free == 3);
+
+    aligned = ((dyn_array_usize)particles.x % DYN_ARRAY_SOA_ALIGNMENT) == 0;
+    aligned &= ((dyn_array_usize)particles.y % DYN_ARRAY_SOA_ALIGNMENT) == 0;
+    aligned &= ((dyn_array_usize)particles.alive % DYN_ARRAY_SOA_ALIGNMENT) == 0;
+    assert(aligned);
+    assert((char *)particles.y >= (char *)(particles.x + particles.capacity));
+    assert((char *)particles.alive >= (char *)(particles.y + particles.capacity));
+
+    /* a column is a plain contiguous array */
+    for (i = 0; i < particles.length; ++i)
+    {
+        sum += particles.x[i];
+    }
+    assert(sum == 4950.0f);
+    assert(particles.y[99] == 198.0f);
+    assert(particles.alive[99] == 1);
+
+    test_particles_swap_remove(&particles, 0);
+    assert(particles.length == 99);
+    assert(particles.x[0] == 99.0f);
+    assert(particles.y[0] == 198.0f);
+    assert(particles.alive[0] == 1);
+
+    /* Indices beyond the length are ignored */
+    test_particles_swap_remove(&particles, 99);
+    assert(particles.length == 99);
+
+    /* growth keeps the content of every column */
+    x_before = particles.x;
+    assert(test_particles_resize(&particles, 1000));
+    assert(particles.length == 1000);
+    assert(particles.capacity == 1024);
+    assert(particles.x != x_before);
+    assert(particles.x[98] == 98.0f);
+    assert(particles.y[1] == 2.0f);
+
+    assert(test_particles_reserve(&particles, 24));
+    assert(particles.capacity == 1024);
+
+    test_particles_free(&particles);
+    assert(particles.memory == NULL);
+    assert(particles.length == 0);
+    assert(dyn_array_stats_free == 5);
+
+    test_particles_swap_remove(&particles, 0);
+    assert(particles.length == 0);
+}
+
+void dyn_array_test_file(void)
+{
+    const char *path = "dyn_array_test.bin";
+    double *numbers = NULL;
+    double *loaded = NULL;
+    float *wrong_type = NULL;
+    int equal = 1;
+    dyn_array_size i;
+
+    for (i = 0; i < 1000; ++i)
+    {
+        dyn_array_add(numbers, (double)i * 0.5);
+    }
+
+    assert(dyn_array_save(numbers, path));
+
+    dyn_array_stats_reset();
+    assert(dyn_array_load(loaded, path));
+    assert(dyn_array_length(loaded) == 1000);
+    assert(dyn_array_capacity(loaded) == 1000);
+    assert(dyn_array_stats_realloc == 1);
+    for (i = 0; i < 1000; ++i)
+    {
+        equal &= loaded[i] == numbers[i];
+    }
+    assert(equal);
+
+    /* loading into a non empty array replaces it */
+    assert(dyn_array_load(loaded, path));
+    assert(dyn_array_length(loaded) == 1000);
+    assert(dyn_array_stats_free == 1);
+
+    /* a different element size, a missing file */
+    assert(!dyn_array_load(wrong_type, path));
+    assert(wrong_type == NULL);
+    assert(!dyn_array_load(loaded, "dyn_array_test_missing.bin"));
+    assert(loaded == NULL);
+
+#ifndef DYN_ARRAY_HEADER_COMPACT
+    /* mapped in place: no allocation, element 0 page aligned */
+    dyn_array_stats_reset();
+    assert(dyn_array_map(loaded, path));
+    assert(dyn_array_stats_realloc == 0);
+    assert(!dyn_array_owns_storage(loaded));
+    assert(((dyn_array_usize)loaded % DYN_ARRAY_FILE_ALIGNMENT) == 0);
+    assert(dyn_array_length(loaded) == 1000);
+    assert(dyn_array_capacity(loaded) == 1000);
+    equal = 1;
+    for (i = 0; i < 1000; ++i)
+    {
+        equal &= loaded[i] == numbers[i];
+    }
+    assert(equal);
+
+    /* writes stay private to the mapping */
+    loaded[0] = 42.0;
+    dyn_array_unmap(loaded);
+    assert(loaded == NULL);
+    assert(dyn_array_map(loaded, path));
+    assert(loaded[0] == 0.0);
+
+    /* dyn_array_free releases the mapping as well, mapping into a mapped array releases the old one first */
+    dyn_array_free(loaded);
+    assert(loaded == NULL);
+    assert(dyn_array_map(loaded, path));
+    assert(dyn_array_map(loaded, path));
+
+    /* growing moves the array into owned memory */
+    dyn_array_add(loaded, 1.0);
+    assert(dyn_array_owns_storage(loaded));
+    assert(dyn_array_length(loaded) == 1001);
+    assert(loaded[999] == 499.5);
+    dyn_array_unmap(loaded);
+    assert(dyn_array_stats_free == 1);
+
+    assert(!dyn_array_map(wrong_type, path));
+#endif
+
+    /* empty arrays round trip as well */
+    dyn_array_clear(numbers);
+    assert(dyn_array_save(numbers, path));
+    assert(dyn_array_load(loaded, path));
+    assert(dyn_array_length(loaded) == 0);
+    dyn_array_free(loaded);
+
+#ifndef DYN_ARRAY_HEADER_COMPACT
+    assert(dyn_array_map(loaded, path));
+    assert(dyn_array_length(loaded) == 0);
+    dyn_array_unmap(loaded);
+#endif
+
+    dyn_array_free(numbers);
+}
+
+#ifndef DYN_ARRAY_HEADER_COMPACT
+void dyn_array_test_persistent(void)
+{
+    const char *path = "dyn_array_test_persistent.bin";
+    int *events = NULL;
+    int *copy = NULL;
+    double *wrong_type = NULL;
+    int equal = 1;
+    dyn_array_size i;
+
+    /* start from an empty file */
+    assert(dyn_array_save(events, path));
+
+    dyn_array_stats_reset();
+    assert(dyn_array_persistent_open(events, path));
+    assert(events != NULL);
+    assert(dyn_array_length(events) == 0);
+    assert(!dyn_array_owns_storage(events));
+
+    /* growth extends the file, the allocator is not involved */
+    for (i = 0; i < 10000; ++i)
+    {
+        dyn_array_add(events, (int)i);
+    }
+    assert(dyn_array_length(events) == 10000);
+    assert(dyn_array_capacity(events) >= 10000);
+    assert(dyn_array_stats_realloc == 0);
+    assert(!dyn_array_owns_storage(events));
+    for (i = 0; i < 10000; ++i)
+    {
+        equal &= events[i] == (int)i;
+    }
+    assert(equal);
+
+    /* only flushed elements are visible in the file */
+    assert(dyn_array_persistent_flush(events));
+    dyn_array_add(events, -1);
+    assert(dyn_array_load(copy, path));
+    assert(dyn_array_length(copy) == 10000);
+    assert(copy[9999] == 9999);
+
+    /* closing flushes and trims the file to the length */
+    dyn_array_persistent_close(events);
+    assert(events == NULL);
+    assert(dyn_array_map(copy, path));
+    assert(dyn_array_length(copy) == 10001);
+    assert(dyn_array_capacity(copy) == 10001);
+    assert(copy[10000] == -1);
+    dyn_array_unmap(copy);
+
+    /* reopened arrays continue where they left off */
+    assert(dyn_array_persistent_open(events, path));
+    assert(dyn_array_length(events) == 10001);
+    assert(events[5000] == 5000);
+    dyn_array_add(events, 7);
+    dyn_array_erase(events, 10000);
+    assert(events[10000] == 7);
+
+    /* dyn_array_free closes like dyn_array_persistent_close: flushed and trimmed */
+    dyn_array_free(events);
+    assert(events == NULL);
+
+    assert(dyn_array_map(copy, path));
+    assert(dyn_array_length(copy) == 10001);
+    assert(dyn_array_capacity(copy) == 10001);
+    assert(copy[10000] == 7);
+    dyn_array_free(copy);
+
+    /* opening into a variable holding a persistent array closes that one first */
+    assert(dyn_array_persistent_open(events, path));
+    dyn_array_add(events, 8);
+    assert(dyn_array_persistent_open(events, path));
+    assert(dyn_array_length(events) == 10002);
+    assert(events[10001] == 8);
+    dyn_array_free(events);
+
+    assert(!dyn_array_persistent_open(wrong_type, path));
+    assert(wrong_type == NULL);
+}
+#endif
+
+void *dyn_array_test_statistics_run(void *argument)
+{
+    int i;
+    int j;
+
+    (void)argument;
+
+    for (i = 0; i < 200; ++i)
+    {
+        int *values = NULL;
+
+        for (j = 0; j < 50; ++j)
+        {
+            dyn_array_add(values, j);
+        }
+        dyn_array_free(values);
+    }
+
+    return NULL;
+}
+
+void dyn_array_test_statistics(void)
+{
+    dyn_array_stats before;
+    dyn_array_stats after;
+    dyn_array_stats total;
+    DYN_ARRAY_THREAD threads[4];
+    dyn_array_usize bytes;
+    dyn_array_usize slack;
+    dyn_array_usize freed;
+    int *values = NULL;
+    int *q = NULL;
+    int i;
+
+    dyn_array_stats_reset();
+    dyn_array_stats_snapshot(&before);
+    assert(before.bytes_peak == before.bytes);
+
+    /* live bytes follow the capacity and return to the start on free */
+    dyn_array_init(values, 4);
+    bytes = dyn_array_capacity(values) * sizeof(int) + DYN_ARRAY_ALLOCATION_OVERHEAD;
+    dyn_array_stats_snapshot(&after);
+    assert(after.bytes - before.bytes == bytes);
+    assert(after.bytes_peak == after.bytes);
+
+    for (i = 0; i < 100; ++i)
+    {
+        dyn_array_add(values, i);
+    }
+    bytes = dyn_array_capacity(values) * sizeof(int) + DYN_ARRAY_ALLOCATION_OVERHEAD;
+    slack = (dyn_array_capacity(values) - 100) * sizeof(int);
+    dyn_array_stats_snapshot(&after);
+    assert(after.bytes - before.bytes == bytes);
+    assert(after.bytes_peak >= after.bytes);
+
+    dyn_array_free(values);
+    dyn_array_stats_snapshot(&after);
+    freed = after.histogram[dyn_array_log2(100 * sizeof(int))] - before.histogram[dyn_array_log2(100 * sizeof(int))];
+    assert(after.bytes == before.bytes);
+    assert(after.bytes_peak - before.bytes >= bytes);
+    assert(after.bytes_slack - before.bytes_slack == slack);
+    assert(freed == 1);
+    assert(after.frees - before.frees == after.inits - before.inits);
+
+    /* a deque grows by copying its elements into a new block */
+    dyn_array_stats_snapshot(&before);
+    for (i = 0; i < 5; ++i)
+    {
+        dyn_array_deque_push_back(q, i);
+    }
+    dyn_array_stats_snapshot(&after);
+    assert(after.bytes_copied - before.bytes_copied == 4 * sizeof(int));
+    dyn_array_deque_free(q);
+    dyn_array_stats_snapshot(&after);
+    assert(after.bytes == before.bytes);
+
+    /* threads update the counters atomically */
+    dyn_array_stats_snapshot(&before);
+    for (i = 0; i < 4; ++i)
+    {
+        assert(DYN_ARRAY_THREAD_CREATE(threads[i], dyn_array_test_statistics_run, NULL));
+    }
+    for (i = 0; i < 4; ++i)
+    {
+        DYN_ARRAY_THREAD_JOIN(threads[i]);
+    }
+    dyn_array_stats_snapshot(&after);
+    assert(after.inits - before.inits == 800);
+    assert(after.frees - before.frees == 800);
+    assert(after.bytes == before.bytes);
+
+    /* a reset while threads run keeps the allocated bytes */
+    for (i = 0; i < 4; ++i)
+    {
+        assert(DYN_ARRAY_THREAD_CREATE(threads[i], dyn_array_test_statistics_run, NULL));
+    }
+    for (i = 0; i < 100; ++i)
+    {
+        dyn_array_stats_reset();
+    }
+    for (i = 0; i < 4; ++i)
+    {
+        DYN_ARRAY_THREAD_JOIN(threads[i]);
+    }
+    dyn_array_stats_snapshot(&after);
+    assert(after.bytes == before.bytes);
+    assert(after.bytes_peak >= after.bytes);
+    assert(after.frees <= 800);
+
+    /* merging adds every value */
+    dyn_array_memory_zero(&total, sizeof(total));
+    dyn_array_stats_merge(&total, &after);
+    dyn_array_stats_merge(&total, &after);
+    assert(total.inits == 2 * after.inits);
+    assert(total.bytes_slack == 2 * after.bytes_slack);
+    assert(total.histogram[0] == 2 * after.histogram[0]);
+}
+
+int dyn_array_test_is_this_file(unsigned int index)
+{
+    const char *name = index < DYN_ARRAY_TRACE_FILES ? dyn_array_trace_global.files[index] : NULL;
+    const char *expected = __FILE__;
+    unsigned int i = 0;
+
+    while (name && name[i] && name[i] == expected[i])
+    {
+        i++;
+    }
+
+    return name && name[i] == expected[i];
+}
+
+void dyn_array_test_trace(void)
+{
+    dyn_array_trace_event events[64];
+    dyn_array_trace_header header;
+    dyn_array_trace_event *event = dyn_array_trace_global.events;
+    dyn_array_file_handle file;
+    char name[sizeof(__FILE__)];
+    int *values = NULL;
+    int line;
+    int ok;
+    unsigned int mismatches = 0;
+    unsigned int i;
+
+    dyn_array_trace_reset();
+
+    /* every grow and free carries the line of the macro call */
+    line = __LINE__ + 1;
+    dyn_array_init(values, 4);
+    for (i = 0; i < 5; ++i)
+    {
+        dyn_array_add(values, (int)i);
+    }
+    dyn_array_free(values);
+
+    assert(dyn_array_trace_global.recorded == 3);
+    assert(event[0].kind == DYN_ARRAY_TRACE_GROW);
+    assert(event[0].array == 0);
+    assert(event[0].requested == 4 && event[0].add_length == 0);
+    assert(event[0].new_capacity == 4);
+    assert(event[0].line == (unsigned int)line);
+    assert(dyn_array_test_is_this_file(event[0].file));
+    assert(event[1].array == event[0].moved);
+    assert(event[1].length == 4 && event[1].add_length == 1);
+    assert(event[1].old_capacity == 4 && event[1].new_capacity > 4);
+    assert(event[1].line == (unsigned int)line + 3);
+    assert(event[2].kind == DYN_ARRAY_TRACE_FREE);
+    assert(event[2].array == event[1].moved);
+    assert(event[2].length == 5 && event[2].old_capacity == event[1].new_capacity);
+    assert(event[2].line == (unsigned int)line + 5);
+    assert(event[1].timestamp >= event[0].timestamp);
+    assert(dyn_array_trace_dump("dyn_array_test_trace.bin"));
+
+    /* the ring keeps the last events and the dump starts with the oldest of them */
+    for (i = 0; i < DYN_ARRAY_TRACE_EVENTS / 2 + 25; ++i)
+    {
+        dyn_array_init(values, 1);
+        dyn_array_free(values);
+    }
+    assert(dyn_array_trace_dump("dyn_array_test_trace.bin"));
+
+    file = dyn_array_file_open("dyn_array_test_trace.bin", DYN_ARRAY_FILE_READ);
+    assert(file != DYN_ARRAY_FILE_INVALID);
+    ok = dyn_array_file_read(file, &header, sizeof(header));
+    ok = ok && dyn_array_file_seek(file, sizeof(header) + header.files * sizeof(unsigned int) + sizeof(__FILE__) - 1);
+    ok = ok && dyn_array_file_read(file, events, sizeof(events));
+    dyn_array_file_close(file);
+    assert(ok);
+    assert(header.version == DYN_ARRAY_TRACE_VERSION);
+    assert(header.event_size == sizeof(dyn_array_trace_event));
+    assert(header.files == 1);
+    assert(header.events == DYN_ARRAY_TRACE_EVENTS);
+    assert(header.dropped == 3 + 2 * 25);
+
+    for (i = 0; i < 64; ++i)
+    {
+        mismatches += events[i].kind != (i % 2 ? DYN_ARRAY_TRACE_FREE : DYN_ARRAY_TRACE_GROW);
+    }
+    assert(mismatches == 0);
+    assert(events[63].array == events[62].moved && events[63].line == events[61].line);
+
+    /* a name at another address, e.g. the __FILE__ of another translation unit, finds the slot of the same name */
+    dyn_array_memory_copy(name, __FILE__, sizeof(name));
+    assert(dyn_array_trace_file_index(name) == events[63].file);
+    assert(!dyn_array_trace_global.files[1]);
+}
+
 int main(void)
 {
 
@@ -201,6 +2256,40 @@ int main(void)
     dyn_array_test_complex_type();
     dyn_array_test_big_capacity();
     dyn_array_test_add_array();
+    dyn_array_test_add_array_bulk();
+    dyn_array_test_header_layout();
+    dyn_array_test_memory_move();
+    dyn_array_test_capacity_management();
+    dyn_array_test_add_uninitialized();
+#ifndef DYN_ARRAY_HEADER_COMPACT
+    dyn_array_test_init_buffer();
+#endif
+    dyn_array_test_insert_erase();
+    dyn_array_test_sort();
+    dyn_array_test_radix_sort();
+    dyn_array_test_sorted_arrays();
+    dyn_array_test_numeric();
+    dyn_array_test_filter();
+    dyn_array_test_parallel();
+    dyn_array_test_concurrent();
+    dyn_array_test_segmented();
+    dyn_array_test_deque();
+    dyn_array_test_soa();
+    dyn_array_test_file();
+#ifndef DYN_ARRAY_HEADER_COMPACT
+    dyn_array_test_persistent();
+#endif
+    dyn_array_test_statistics();
+    dyn_array_test_trace();
+#ifdef DYN_ARRAY_AUTO_SHRINK
+    dyn_array_test_auto_shrink();
+#endif
+    dyn_array_test_grow_policies();
+    dyn_array_test_size_overflow();
+    dyn_array_test_virtual_memory();
+#ifdef DYN_ARRAY_MREMAP
+    dyn_array_test_mremap();
+#endif
 
     return 0;
 }
@@ -0,0 +1,204 @@
+/* perf.h - v0.1 - public domain data structures - nickscha 2025
+
+A C89 standard compliant, single header, nostdlib (no C Standard Library) timing helper for micro benchmarks.
+
+BACKENDS
+
+  The tick source is selected at compile-time:
+
+    x86 / x64 with gcc, clang or msvc : rdtsc (calibrated against the OS clock in perf_init)
+    win32                             : QueryPerformanceCounter
+    everything else                   : clock_gettime(CLOCK_MONOTONIC)
+
+  #define PERF_NO_RDTSC
+
+    Forces the OS clock backend even if rdtsc is available.
+
+USAGE
+
+    double t0, t1;
+
+    perf_init();                 // Calibrate the tick source once
+
+    t0 = perf_ticks();
+    do_work();
+    t1 = perf_ticks();
+
+    printf("%f ns\n", perf_ns(t0, t1));
+
+LICENSE
+
+  Placed in the public domain and also MIT licensed.
+  See end of file for detailed license information.
+
+*/
+#ifndef PERF_H
+#define PERF_H
+
+/* #############################################################################
+ * # COMPILER SETTINGS
+ * #############################################################################
+ */
+/* Check if using C99 or later (inline is supported) */
+#if __STDC_VERSION__ >= 199901L
+#define PERF_INLINE inline
+#elif defined(__GNUC__) || defined(__clang__)
+#define PERF_INLINE __inline__
+#elif defined(_MSC_VER)
+#define PERF_INLINE __inline
+#else
+#define PERF_INLINE
+#endif
+
+#if !defined(PERF_NO_RDTSC) && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define PERF_RDTSC
+static PERF_INLINE double perf_rdtsc(void)
+{
+    unsigned int lo, hi;
+    __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+    return (double)hi * 4294967296.0 + (double)lo;
+}
+#elif !defined(PERF_NO_RDTSC) && defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define PERF_RDTSC
+unsigned __int64 __rdtsc(void);
+#pragma intrinsic(__rdtsc)
+static PERF_INLINE double perf_rdtsc(void)
+{
+    return (double)__rdtsc();
+}
+#endif
+
+#ifdef _WIN32
+/* Windows prototypes since include windows.h is immensily slow !!! */
+typedef struct perf_large_integer
+{
+    unsigned long low;
+    long high;
+} perf_large_integer;
+
+int QueryPerformanceCounter(perf_large_integer *lpPerformanceCount);
+int QueryPerformanceFrequency(perf_large_integer *lpFrequency);
+
+static PERF_INLINE double perf_os_ns(void)
+{
+    perf_large_integer counter;
+    perf_large_integer frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    return ((double)counter.high * 4294967296.0 + (double)counter.low) * 1e9 /
+           ((double)frequency.high * 4294967296.0 + (double)frequency.low);
+}
+#elif defined(CLOCK_MONOTONIC)
+/* <time.h> was already included (e.g. through pthread.h) and declares clock_gettime */
+#define PERF_CLOCK_MONOTONIC CLOCK_MONOTONIC
+#define perf_timespec timespec
+
+static PERF_INLINE double perf_os_ns(void)
+{
+    struct perf_timespec ts;
+    clock_gettime(PERF_CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+#else
+/* POSIX prototypes so no libc header has to be pulled in */
+#ifdef __APPLE__
+#define PERF_CLOCK_MONOTONIC 6
+#else
+#define PERF_CLOCK_MONOTONIC 1
+#endif
+
+struct perf_timespec
+{
+    long tv_sec;
+    long tv_nsec;
+};
+
+int clock_gettime(int clock_id, struct perf_timespec *tp);
+
+static PERF_INLINE double perf_os_ns(void)
+{
+    struct perf_timespec ts;
+    clock_gettime(PERF_CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+#endif
+
+/* Ticks per nanosecond of the selected backend, set by perf_init */
+static double perf_ticks_per_ns = 1.0;
+
+static PERF_INLINE double perf_ticks(void)
+{
+#ifdef PERF_RDTSC
+    return perf_rdtsc();
+#else
+    return perf_os_ns();
+#endif
+}
+
+/* Calibrates the tick source against the OS clock by spinning for ~20ms */
+static PERF_INLINE void perf_init(void)
+{
+#ifdef PERF_RDTSC
+    double ns_start = perf_os_ns();
+    double ticks_start = perf_rdtsc();
+    double ns_end;
+
+    do
+    {
+        ns_end = perf_os_ns();
+    } while (ns_end - ns_start < 20000000.0);
+
+    perf_ticks_per_ns = (perf_rdtsc() - ticks_start) / (ns_end - ns_start);
+#else
+    perf_ticks_per_ns = 1.0;
+#endif
+}
+
+static PERF_INLINE double perf_ns(double ticks_start, double ticks_end)
+{
+    return (ticks_end - ticks_start) / perf_ticks_per_ns;
+}
+
+#endif /* PERF_H */
+
+/*
+   ------------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+*/